@@ -1,5 +1,5 @@
-#include "image_reader.hpp"
-#include "image_writer.hpp"
+#include "ImageReader.hpp"
+#include "ImageWriter.hpp"
 #include "BilateralFilter.hpp"
 #include <vector>
 #include <cstdint>
@@ -26,7 +26,6 @@ int main() {
     ImageReader reader;
     ImageWriter writer;
     Image image;
-    BilateralFilter BilateralFilter;
     int kernelSize = 7;
     double sigmaSpatial = 3.0;
     double sigmaIntensity = 15.0;
@@ -42,12 +41,13 @@ int main() {
     //Sometimes applying the kernel only once is not enough to get the best results
     //so we apply the kernel twice to get the best results
     for(int count=0; count == 2 ; count++){
-      std::vector<std::vector<uint8_t>> filteredMatrix = BilateralFilter::apply(
-        image.pixelMatrix,
+      Image<uint8_t> filtered = BilateralFilter<>::apply(
+        image.cview(),
         kernelSize,
         sigmaSpatial,
         sigmaIntensity);
-    image.pixelMatrix = filteredMatrix;
+    filtered.metadata = image.metadata;
+    image = std::move(filtered);
     count++;
     }
     
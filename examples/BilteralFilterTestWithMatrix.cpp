@@ -2,10 +2,11 @@
 #include <iostream>
 #include <vector>
 #include <iomanip> 
+#include <algorithm>
 
 int main() {
     // Define a 9x9 test matrix (grayscale image)
-    std::vector<std::vector<uint8_t>> testMatrix = {
+    const std::vector<std::vector<uint8_t>> testRows = {
         {10, 10, 10, 10, 10, 10, 10, 10, 10},
         {10, 20, 20, 20, 20, 20, 20, 20, 10},
         {10, 20, 30, 30, 30, 30, 30, 20, 10},
@@ -17,14 +18,19 @@ int main() {
         {10, 10, 10, 10, 10, 10, 10, 10, 10}
     };
 
+    Image<uint8_t> testMatrix(9, 9);
+    for (uint32_t i = 0; i < 9; ++i) {
+        std::copy(testRows[i].begin(), testRows[i].end(), testMatrix.row(i));
+    }
+
     // Bilateral filter parameters
     int kernelSize = 5;          // Kernel size
     double sigmaSpatial = 2.0;   // Spatial sigma
     double sigmaIntensity = 10.0; // Intensity sigma
 
     // Apply the bilateral filter
-    std::vector<std::vector<uint8_t>> filteredMatrix = BilateralFilter::apply(
-        testMatrix,
+    Image<uint8_t> filteredMatrix = BilateralFilter<>::apply(
+        testMatrix.cview(),
         kernelSize,
         sigmaSpatial,
         sigmaIntensity
@@ -33,9 +39,9 @@ int main() {
 
     // Print the filtered matrix
     std::cout << "\nFiltered Matrix:" << std::endl;
-    for (const auto& row : filteredMatrix) {
-        for (const auto& pixel : row) {
-            std::cout << std::setw(3) << static_cast<int>(pixel) << " ";
+    for (uint32_t i = 0; i < filteredMatrix.metadata.height; ++i) {
+        for (uint32_t j = 0; j < filteredMatrix.metadata.width; ++j) {
+            std::cout << std::setw(3) << static_cast<int>(filteredMatrix.row(i)[j]) << " ";
         }
         std::cout << std::endl;
     }
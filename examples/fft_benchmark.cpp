@@ -0,0 +1,182 @@
+#include "FFT.hpp"
+#include "FFTPlan.hpp"
+#include "ThreadPool.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+// Per-call transform as it was before FFTPlan: bit reversal recomputed and
+// twiddles accumulated with w = w * wn on every call.
+static void legacyFFT(vector<Complex> &x, bool inverse)
+{
+    size_t n = x.size();
+    size_t j = 0;
+    for (size_t i = 1; i < n; i++) {
+        size_t bit = n >> 1;
+        while (j >= bit) {
+            j -= bit;
+            bit >>= 1;
+        }
+        j += bit;
+        if (i < j) swap(x[i], x[j]);
+    }
+    for (size_t len = 2; len <= n; len *= 2) {
+        double angle = 2 * M_PI / len * (inverse ? -1 : 1);
+        Complex wn(cos(angle), sin(angle));
+        for (size_t i = 0; i < n; i += len) {
+            Complex w(1, 0);
+            for (size_t k = 0; k < len / 2; k++) {
+                Complex t = w * x[i + k + len / 2];
+                Complex u = x[i + k];
+                x[i + k] = u + t;
+                x[i + k + len / 2] = u - t;
+                w = w * wn;
+            }
+        }
+    }
+    if (inverse) {
+        for (size_t i = 0; i < n; i++) x[i] *= (1.0 / n);
+    }
+}
+
+static void legacyFFT2D(vector<vector<Complex>> &image, bool inverse)
+{
+    size_t rows = image.size();
+    size_t cols = image[0].size();
+    for (size_t i = 0; i < rows; i++) legacyFFT(image[i], inverse);
+    for (size_t j = 0; j < cols; j++) {
+        vector<Complex> col(rows);
+        for (size_t i = 0; i < rows; i++) col[i] = image[i][j];
+        legacyFFT(col, inverse);
+        for (size_t i = 0; i < rows; i++) image[i][j] = col[i];
+    }
+}
+
+// Planned transforms with the column pass as it was before split storage:
+// every column gathered into a temporary vector and scattered back.
+static void gatherFFT2D(vector<vector<Complex>> &image, const FFTPlan<> &plan, bool inverse)
+{
+    size_t rows = image.size();
+    size_t cols = image[0].size();
+    for (size_t i = 0; i < rows; i++) plan.execute(image[i], inverse);
+    vector<Complex> col(rows);
+    for (size_t j = 0; j < cols; j++) {
+        for (size_t i = 0; i < rows; i++) col[i] = image[i][j];
+        plan.execute(col, inverse);
+        for (size_t i = 0; i < rows; i++) image[i][j] = col[i];
+    }
+}
+
+template <typename S>
+static void toSplit(const vector<vector<Complex>> &frame, SplitComplexImage<S> &split)
+{
+    split.resize(frame.size(), frame[0].size());
+    for (size_t i = 0; i < split.rows; i++)
+        for (size_t j = 0; j < split.cols; j++) {
+            split.realRow(i)[j] = static_cast<S>(frame[i][j].real);
+            split.imagRow(i)[j] = static_cast<S>(frame[i][j].imag);
+        }
+}
+
+template <typename S>
+static double maxError(const SplitComplexImage<S> &split, const vector<vector<Complex>> &b)
+{
+    double err = 0.0;
+    for (size_t i = 0; i < split.rows; i++)
+        for (size_t j = 0; j < split.cols; j++)
+            err = max(err, (Complex(split.realRow(i)[j], split.imagRow(i)[j]) - b[i][j]).magnitude());
+    return err;
+}
+
+static vector<vector<Complex>> makeFrame(size_t n)
+{
+    vector<vector<Complex>> frame(n, vector<Complex>(n));
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = 0; j < n; j++)
+            frame[i][j] = Complex(static_cast<double>((i * 31 + j * 17) % 256), 0.0);
+    return frame;
+}
+
+template <typename Frame, typename Fn>
+static double timeFrames(Frame &frame, int frames, Fn transform)
+{
+    auto start = chrono::steady_clock::now();
+    for (int f = 0; f < frames; f++) {
+        transform(frame, false);
+        transform(frame, true);
+    }
+    chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+    return elapsed.count() / frames;
+}
+
+static double maxError(const vector<vector<Complex>> &a, const vector<vector<Complex>> &b)
+{
+    double err = 0.0;
+    for (size_t i = 0; i < a.size(); i++)
+        for (size_t j = 0; j < a[i].size(); j++)
+            err = max(err, (a[i][j] - b[i][j]).magnitude());
+    return err;
+}
+
+int main(int argc, char **argv)
+{
+    // Powers of two only: the legacy transform cannot handle other sizes.
+    vector<size_t> sizes = {512, 4096};
+    if (argc > 1) {
+        sizes.clear();
+        for (int i = 1; i < argc; i++) sizes.push_back(strtoul(argv[i], nullptr, 10));
+    }
+
+    cout << "Forward + inverse 2D FFT, ms per frame" << endl;
+    for (size_t n : sizes) {
+        int frames = n <= 1024 ? 10 : 1;
+        vector<vector<Complex>> original = makeFrame(n);
+
+        vector<vector<Complex>> frame = original;
+        double legacyMs = timeFrames(frame, frames, legacyFFT2D);
+        double legacyErr = maxError(frame, original);
+
+        frame = original;
+        shared_ptr<const FFTPlan<>> plan = FFTPlan<>::get(n);
+        double gatherMs = timeFrames(frame, frames, [&](vector<vector<Complex>> &img, bool inverse) {
+            gatherFFT2D(img, *plan, inverse);
+        });
+        double gatherErr = maxError(frame, original);
+
+        ThreadPool serialPool(0);
+        SplitComplexImage<> split;
+        toSplit(original, split);
+        double splitMs = timeFrames(split, frames, [&](SplitComplexImage<> &img, bool inverse) {
+            FFT<>::fft2D(img, *plan, *plan, inverse, serialPool);
+        });
+        double splitErr = maxError(split, original);
+
+        toSplit(original, split);
+        double parallelMs = timeFrames(split, frames, [&](SplitComplexImage<> &img, bool inverse) {
+            FFT<>::fft2D(img, *plan, *plan, inverse, ThreadPool::shared());
+        });
+        double parallelErr = maxError(split, original);
+
+        shared_ptr<const FFTPlan<float>> floatPlan = FFTPlan<float>::get(n);
+        SplitComplexImage<float> floatSplit;
+        toSplit(original, floatSplit);
+        double floatMs = timeFrames(floatSplit, frames, [&](SplitComplexImage<float> &img, bool inverse) {
+            FFT<>::fft2D(img, *floatPlan, *floatPlan, inverse, serialPool);
+        });
+        double floatErr = maxError(floatSplit, original);
+
+        cout << n << "x" << n
+             << "  legacy: " << legacyMs << " ms (round-trip error " << legacyErr << ")"
+             << "  plan, column gather: " << gatherMs << " ms (" << gatherErr << ")"
+             << "  plan, split blocked: " << splitMs << " ms (" << splitErr << ")"
+             << "  float: " << floatMs << " ms (" << floatErr << ")"
+             << "  parallel, " << ThreadPool::shared().threadCount() << " threads: "
+             << parallelMs << " ms (" << parallelErr << ")"
+             << "  speedup: " << legacyMs / parallelMs << "x" << endl;
+    }
+    return 0;
+}
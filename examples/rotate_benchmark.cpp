@@ -0,0 +1,104 @@
+#include "Rotate.hpp"
+#include "Flipping.hpp"
+#include "ImageWriter.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+// The quarter turn as it was before tiling: source rows read in order,
+// destination written a column at a time, one cache line per pixel.
+static void legacyRotate90CW(const ImageView<const uint8_t> &src, const ImageView<uint8_t> &dst)
+{
+    size_t rows = src.height();
+    size_t cols = src.width();
+    for (size_t i = 0; i < rows; ++i) {
+        const uint8_t *srcRow = src.row(i);
+        for (size_t j = 0; j < cols; ++j) dst(j, rows - 1 - i) = srcRow[j];
+    }
+}
+
+// The horizontal flip as it was: one swap_ranges call per pixel.
+static void legacyFlipHorizontal(const ImageView<uint8_t> &view)
+{
+    size_t width = view.width();
+    for (size_t i = 0; i < view.height(); ++i) {
+        uint8_t *row = view.row(i);
+        for (size_t j = 0; j < width / 2; ++j) swap_ranges(row + j, row + j + 1, row + width - 1 - j);
+    }
+}
+
+// Best of `runs` calls, in milliseconds.
+template <typename Fn>
+static double bestOf(int runs, Fn operation)
+{
+    double best = 0.0;
+    for (int r = 0; r < runs; r++) {
+        auto start = chrono::steady_clock::now();
+        operation();
+        chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+        if (r == 0 || elapsed.count() < best) best = elapsed.count();
+    }
+    return best;
+}
+
+int main(int argc, char **argv)
+{
+    vector<uint32_t> sizes = {512, 4096, 16384};
+    if (argc > 1) {
+        sizes.clear();
+        for (int i = 1; i < argc; i++) sizes.push_back(static_cast<uint32_t>(atoi(argv[i])));
+    }
+
+    cout << "8-bit square images, ms" << endl;
+    for (uint32_t n : sizes) {
+        int runs = n >= 16384 ? 2 : 5;
+        Image<uint8_t> image(n, n), rotated(n, n);
+        for (uint32_t i = 0; i < n; i++)
+            for (uint32_t j = 0; j < n; j++) image.row(i)[j] = static_cast<uint8_t>(i * 31 + j * 7);
+
+        double legacyMs = bestOf(runs, [&] { legacyRotate90CW(image.cview(), rotated.view()); });
+        double tiledMs = bestOf(runs, [&] {
+            ImageRotator<uint8_t>::rotate(image.cview(), rotated.view(), RotationDirection::CW_90);
+        });
+        // Rotating an Image only records the turn; materialize() moves the pixels.
+        double inPlaceMs = bestOf(runs, [&] {
+            ImageRotator<uint8_t>::rotate(image, RotationDirection::CW_90);
+            image.materialize();
+        });
+        double legacyFlipMs = bestOf(runs, [&] { legacyFlipHorizontal(image.view()); });
+        double flipMs = bestOf(runs, [&] {
+            ImageFlipper<uint8_t>::flip(image, FlippingDirection::HORIZONTAL);
+            image.materialize();
+        });
+
+        // A normalise-then-flip chain written to disk: every step rewriting
+        // the pixels, against composing the steps and letting the writer
+        // gather the reoriented rows.
+        image.metadata.format = ImageFormat::PGM;
+        image.metadata.maxValue = 255;
+        ImageWriter<uint8_t> writer;
+        double eagerChainMs = bestOf(runs, [&] {
+            ImageRotator<uint8_t>::rotate(image.cview(), rotated.view(), RotationDirection::CW_90);
+            ImageFlipper<uint8_t>::flip(rotated.view(), FlippingDirection::HORIZONTAL);
+            ImageFlipper<uint8_t>::flip(rotated.view(), FlippingDirection::VERTICAL);
+            writer.writeImage("rotate_benchmark.pgm", rotated.cview(), image.metadata);
+        });
+        double lazyChainMs = bestOf(runs, [&] {
+            ImageRotator<uint8_t>::rotate(image, RotationDirection::CW_90);
+            ImageFlipper<uint8_t>::flip(image, FlippingDirection::HORIZONTAL);
+            ImageFlipper<uint8_t>::flip(image, FlippingDirection::VERTICAL);
+            writer.writeImage("rotate_benchmark.pgm", image);
+        });
+
+        cout << n << " x " << n << "  rotate 90: column-wise " << legacyMs << "  tiled " << tiledMs
+             << "  in place " << inPlaceMs << " (" << legacyMs / tiledMs << "x)"
+             << "  flip: per pixel " << legacyFlipMs << "  word reversal " << flipMs
+             << " (" << legacyFlipMs / flipMs << "x)"
+             << "  turn+flips+write: eager " << eagerChainMs << "  lazy " << lazyChainMs << endl;
+    }
+    return 0;
+}
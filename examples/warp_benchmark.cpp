@@ -0,0 +1,85 @@
+#include "Warp.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+// Bilinear warp the direct way: every output pixel multiplies its
+// coordinates through the inverse matrix in double, takes floor() and
+// computes its weights, and the image is walked row by row.
+static Image<uint8_t> naiveBilinear(const ImageView<const uint8_t> &image, const AffineTransform &transform)
+{
+    AffineTransform inverse = transform.inverse();
+    Image<uint8_t> output(image.width(), image.height());
+    int width = image.width(), height = image.height();
+    for (int i = 0; i < height; i++) {
+        for (int j = 0; j < width; j++) {
+            pair<double, double> p = inverse.apply(j, i);
+            double fx = floor(p.first), fy = floor(p.second);
+            double tx = p.first - fx, ty = p.second - fy;
+            int x = static_cast<int>(fx), y = static_cast<int>(fy);
+            double sum = 0.0;
+            for (int dy = 0; dy < 2; dy++) {
+                for (int dx = 0; dx < 2; dx++) {
+                    if (x + dx < 0 || x + dx >= width || y + dy < 0 || y + dy >= height) continue;
+                    sum += (dy ? ty : 1 - ty) * (dx ? tx : 1 - tx) * image(y + dy, x + dx);
+                }
+            }
+            output.row(i)[j] = static_cast<uint8_t>(min(sum + 0.5, 255.0));
+        }
+    }
+    return output;
+}
+
+// Best of `runs` calls, in milliseconds.
+template <typename Fn>
+static double bestOf(int runs, Fn operation)
+{
+    double best = 0.0;
+    for (int r = 0; r < runs; r++) {
+        auto start = chrono::steady_clock::now();
+        operation();
+        chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+        if (r == 0 || elapsed.count() < best) best = elapsed.count();
+    }
+    return best;
+}
+
+int main(int argc, char **argv)
+{
+    vector<uint32_t> sizes = {512, 4096};
+    if (argc > 1) {
+        sizes.clear();
+        for (int i = 1; i < argc; i++) sizes.push_back(static_cast<uint32_t>(atoi(argv[i])));
+    }
+
+    cout << "8-bit rotations about the centre, ms" << endl;
+    for (uint32_t n : sizes) {
+        int runs = n >= 4096 ? 2 : 5;
+        Image<uint8_t> image(n, n);
+        for (uint32_t i = 0; i < n; i++)
+            for (uint32_t j = 0; j < n; j++) image.row(i)[j] = static_cast<uint8_t>((i / 8 + j / 8) % 2 ? 220 : 30);
+
+        for (double degrees : {3.0, 30.0}) {
+            AffineTransform turn = AffineTransform::rotation(degrees, (n - 1) / 2.0, (n - 1) / 2.0);
+            double naiveMs = bestOf(runs, [&] { naiveBilinear(image.cview(), turn); });
+            double nearestMs = bestOf(runs, [&] {
+                ImageWarper<uint8_t>::warp(image.cview(), turn, n, n, Interpolation::NEAREST);
+            });
+            double bilinearMs = bestOf(runs, [&] {
+                ImageWarper<uint8_t>::warp(image.cview(), turn, n, n, Interpolation::BILINEAR);
+            });
+            double bicubicMs = bestOf(runs, [&] {
+                ImageWarper<uint8_t>::warp(image.cview(), turn, n, n, Interpolation::BICUBIC);
+            });
+
+            cout << n << " x " << n << " by " << degrees << " deg  per-pixel matrix bilinear " << naiveMs
+                 << "  tiled fixed-point: nearest " << nearestMs << "  bilinear " << bilinearMs << " ("
+                 << naiveMs / bilinearMs << "x)  bicubic " << bicubicMs << endl;
+        }
+    }
+    return 0;
+}
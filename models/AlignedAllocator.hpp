@@ -0,0 +1,45 @@
+#ifndef ALIGNED_ALLOCATOR_HPP
+#define ALIGNED_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <new>
+using namespace std;
+
+// Cache-line alignment used for every pixel buffer and row start.
+constexpr size_t PIXEL_ALIGNMENT = 64;
+
+// Minimal allocator handing out PIXEL_ALIGNMENT-aligned storage so that
+// vector-backed buffers start on a cache line (and a full vector register).
+template <typename T, size_t Alignment = PIXEL_ALIGNMENT>
+struct AlignedAllocator
+{
+    using value_type = T;
+
+    template <typename U>
+    struct rebind
+    {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() noexcept = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment> &) noexcept {}
+
+    T *allocate(size_t count)
+    {
+        return static_cast<T *>(::operator new(count * sizeof(T), align_val_t(Alignment)));
+    }
+
+    void deallocate(T *pointer, size_t) noexcept
+    {
+        ::operator delete(pointer, align_val_t(Alignment));
+    }
+};
+
+template <typename T, typename U, size_t Alignment>
+bool operator==(const AlignedAllocator<T, Alignment> &, const AlignedAllocator<U, Alignment> &) { return true; }
+
+template <typename T, typename U, size_t Alignment>
+bool operator!=(const AlignedAllocator<T, Alignment> &, const AlignedAllocator<U, Alignment> &) { return false; }
+
+#endif // ALIGNED_ALLOCATOR_HPP
@@ -0,0 +1,157 @@
+#ifndef BINARY_IMAGE_CPP
+#define BINARY_IMAGE_CPP
+
+#include "BinaryImage.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+template BinaryImage BinaryImage::threshold<uint8_t>(const ImageView<const uint8_t> &, uint8_t);
+template BinaryImage BinaryImage::threshold<uint16_t>(const ImageView<const uint16_t> &, uint16_t);
+template BinaryImage BinaryImage::threshold<uint32_t>(const ImageView<const uint32_t> &, uint32_t);
+template BinaryImage BinaryImage::threshold<uint64_t>(const ImageView<const uint64_t> &, uint64_t);
+template BinaryImage BinaryImage::threshold<float>(const ImageView<const float> &, float);
+template BinaryImage BinaryImage::threshold<double>(const ImageView<const double> &, double);
+
+BinaryImage::BinaryImage(uint32_t width, uint32_t height)
+{
+    allocate(width, height);
+}
+
+void BinaryImage::allocate(uint32_t width, uint32_t height)
+{
+    maskWidth = width;
+    maskHeight = height;
+    rowWords = (static_cast<size_t>(width) + WORD_BITS - 1) / WORD_BITS;
+    words.assign(rowWords * height, 0);
+}
+
+void BinaryImage::set(uint32_t x, uint32_t y, bool value)
+{
+    uint64_t bit = uint64_t(1) << (WORD_BITS - 1 - x % WORD_BITS);
+    uint64_t &word = row(y)[x / WORD_BITS];
+    word = value ? word | bit : word & ~bit;
+}
+
+uint64_t BinaryImage::lastWordMask() const
+{
+    uint32_t used = maskWidth % WORD_BITS;
+    return used == 0 ? ~uint64_t(0) : ~uint64_t(0) << (WORD_BITS - used);
+}
+
+uint64_t BinaryImage::count() const
+{
+    uint64_t total = 0;
+    for (uint64_t word : words)
+    {
+        total += __builtin_popcountll(word);
+    }
+    return total;
+}
+
+void BinaryImage::checkSameSize(const BinaryImage &other) const
+{
+    if (maskWidth != other.maskWidth || maskHeight != other.maskHeight)
+    {
+        throw invalid_argument("Binary image sizes do not match");
+    }
+}
+
+BinaryImage &BinaryImage::operator&=(const BinaryImage &other)
+{
+    checkSameSize(other);
+    for (size_t i = 0; i < words.size(); i++)
+    {
+        words[i] &= other.words[i];
+    }
+    return *this;
+}
+
+BinaryImage &BinaryImage::operator|=(const BinaryImage &other)
+{
+    checkSameSize(other);
+    for (size_t i = 0; i < words.size(); i++)
+    {
+        words[i] |= other.words[i];
+    }
+    return *this;
+}
+
+BinaryImage &BinaryImage::operator^=(const BinaryImage &other)
+{
+    checkSameSize(other);
+    for (size_t i = 0; i < words.size(); i++)
+    {
+        words[i] ^= other.words[i];
+    }
+    return *this;
+}
+
+void BinaryImage::invert()
+{
+    uint64_t tail = lastWordMask();
+    for (uint32_t y = 0; y < maskHeight; y++)
+    {
+        uint64_t *r = row(y);
+        for (size_t i = 0; i < rowWords; i++)
+        {
+            r[i] = ~r[i];
+        }
+        r[rowWords - 1] &= tail;
+    }
+}
+
+bool BinaryImage::operator==(const BinaryImage &other) const
+{
+    return maskWidth == other.maskWidth && maskHeight == other.maskHeight && words == other.words;
+}
+
+template <typename T>
+BinaryImage BinaryImage::threshold(const ImageView<const T> &image, T level)
+{
+    if (image.channels() != 1)
+    {
+        throw invalid_argument("Thresholding needs a single-channel image");
+    }
+    BinaryImage mask(image.width(), image.height());
+    size_t width = image.width();
+    for (uint32_t y = 0; y < image.height(); y++)
+    {
+        const T *inRow = image.row(y);
+        uint64_t *outRow = mask.row(y);
+        for (size_t i = 0; i < mask.rowWords; i++)
+        {
+            size_t begin = i * WORD_BITS;
+            size_t count = min<size_t>(WORD_BITS, width - begin);
+            uint64_t word = 0;
+            for (size_t b = 0; b < count; b++)
+            {
+                word |= static_cast<uint64_t>(inRow[begin + b] > level) << (WORD_BITS - 1 - b);
+            }
+            outRow[i] = word;
+        }
+    }
+    return mask;
+}
+
+BinaryImage operator&(BinaryImage a, const BinaryImage &b)
+{
+    return a &= b;
+}
+
+BinaryImage operator|(BinaryImage a, const BinaryImage &b)
+{
+    return a |= b;
+}
+
+BinaryImage operator^(BinaryImage a, const BinaryImage &b)
+{
+    return a ^= b;
+}
+
+BinaryImage operator~(BinaryImage a)
+{
+    a.invert();
+    return a;
+}
+
+#endif // BINARY_IMAGE_CPP
@@ -0,0 +1,71 @@
+#ifndef BINARY_IMAGE_HPP
+#define BINARY_IMAGE_HPP
+
+#include "ImageView.hpp"
+#include "AlignedAllocator.hpp"
+#include <cstdint>
+#include <vector>
+using namespace std;
+
+// Bit-packed single-channel mask, 64 pixels per word. Within a row, pixel x
+// is bit 63 - x % 64 of word x / 64, so a word written out most significant
+// byte first is exactly a stretch of a PBM (P4) raster row. Rows start on a
+// word boundary; the bits past the width in each row's last word are kept
+// zero, which is what makes count() and the logic operators word-parallel.
+class BinaryImage
+{
+public:
+    static const uint32_t WORD_BITS = 64;
+
+    BinaryImage() = default;
+    BinaryImage(uint32_t width, uint32_t height);
+
+    // (Re)allocates an all-zero mask of the given size.
+    void allocate(uint32_t width, uint32_t height);
+
+    uint32_t width() const { return maskWidth; }
+    uint32_t height() const { return maskHeight; }
+    size_t wordsPerRow() const { return rowWords; }
+    bool empty() const { return words.empty(); }
+
+    uint64_t *row(uint32_t y) { return words.data() + y * rowWords; }
+    const uint64_t *row(uint32_t y) const { return words.data() + y * rowWords; }
+
+    bool get(uint32_t x, uint32_t y) const { return (row(y)[x / WORD_BITS] >> (WORD_BITS - 1 - x % WORD_BITS)) & 1; }
+    void set(uint32_t x, uint32_t y, bool value);
+
+    // Mask of the bits of a row's last word that lie inside the image.
+    uint64_t lastWordMask() const;
+
+    // Number of set pixels, by popcount over whole words.
+    uint64_t count() const;
+
+    // Word-by-word logic; both masks must have the same size.
+    BinaryImage &operator&=(const BinaryImage &other);
+    BinaryImage &operator|=(const BinaryImage &other);
+    BinaryImage &operator^=(const BinaryImage &other);
+    // Inverts every pixel in place.
+    void invert();
+
+    bool operator==(const BinaryImage &other) const;
+    bool operator!=(const BinaryImage &other) const { return !(*this == other); }
+
+    // Pixels of a single-channel image above `level` become set.
+    template <typename T>
+    static BinaryImage threshold(const ImageView<const T> &image, T level);
+
+private:
+    void checkSameSize(const BinaryImage &other) const;
+
+    uint32_t maskWidth = 0;
+    uint32_t maskHeight = 0;
+    size_t rowWords = 0;
+    vector<uint64_t, AlignedAllocator<uint64_t>> words;
+};
+
+BinaryImage operator&(BinaryImage a, const BinaryImage &b);
+BinaryImage operator|(BinaryImage a, const BinaryImage &b);
+BinaryImage operator^(BinaryImage a, const BinaryImage &b);
+BinaryImage operator~(BinaryImage a);
+
+#endif // BINARY_IMAGE_HPP
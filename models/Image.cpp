@@ -2,15 +2,331 @@
 #define IMAGE_CPP
 
 #include "Image.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+template struct Image<uint8_t>;
+template struct Image<uint16_t>;
+template struct Image<uint32_t>;
+template struct Image<uint64_t>;
+template struct Image<float>;
+template struct Image<double>;
+
+template <typename T>
+Image<T>::Image(uint32_t width, uint32_t height, uint32_t channels)
+{
+    allocate(width, height, channels);
+}
+
+template <typename T>
+size_t Image<T>::alignedStride(size_t rowLength)
+{
+    size_t rowBytes = rowLength * sizeof(T);
+    size_t alignedBytes = (rowBytes + PIXEL_ALIGNMENT - 1) / PIXEL_ALIGNMENT * PIXEL_ALIGNMENT;
+    return alignedBytes / sizeof(T);
+}
+
+template <typename T>
+void Image<T>::allocate(uint32_t width, uint32_t height, uint32_t channels)
+{
+    if (channels == 0)
+    {
+        throw invalid_argument("Image must have at least one channel");
+    }
+    metadata.width = width;
+    metadata.height = height;
+    metadata.channels = channels;
+    rowStride = alignedStride(static_cast<size_t>(width) * channels);
+    pixels.assign(rowStride * height, T(0));
+    pending = Orientation();
+}
+
+template <typename T>
+void Image<T>::clear()
+{
+    pixels.clear();
+    pixels.shrink_to_fit();
+    rowStride = 0;
+    pending = Orientation();
+    metadata.width = 0;
+    metadata.height = 0;
+}
+
+template <typename T>
+void Image<T>::reorient(const Orientation &change)
+{
+    pending = pending.then(change);
+    if (change.swapsAxes())
+    {
+        swap(metadata.width, metadata.height);
+    }
+}
+
+template <typename T>
+ImageView<const T> Image<T>::storedView() const
+{
+    uint32_t width = pending.swapsAxes() ? metadata.height : metadata.width;
+    uint32_t height = pending.swapsAxes() ? metadata.width : metadata.height;
+    return ImageView<const T>(pixels.data(), width, height, rowStride, metadata.channels);
+}
+
+template <typename T>
+OrientedLayout Image<T>::orientedLayout() const
+{
+    // Three points pin down the affine map: the origin and one step along
+    // each axis of the reoriented image.
+    auto offset = [&](int64_t y, int64_t x)
+    {
+        pair<int64_t, int64_t> stored = pending.sourceOf(metadata.width, metadata.height, y, x);
+        return static_cast<ptrdiff_t>(stored.first * static_cast<int64_t>(rowStride) +
+                                      stored.second * static_cast<int64_t>(metadata.channels));
+    };
+    OrientedLayout layout;
+    layout.origin = offset(0, 0);
+    layout.rowStep = offset(1, 0) - layout.origin;
+    layout.pixelStep = offset(0, 1) - layout.origin;
+    return layout;
+}
+
+// Pixels per side of the tiles that reoriented copies and in-place quarter
+// turns walk, so source and destination lines both stay in L1.
+static const size_t REORIENT_TILE = 32;
+
+// Reverses the order of the `channels`-sample pixels of a row.
+template <typename T>
+static void reversePixels(T *row, size_t width, size_t channels)
+{
+    if (channels == 1)
+    {
+        reverseSamples(row, width);
+        return;
+    }
+    for (size_t j = 0; j < width / 2; ++j)
+    {
+        swap_ranges(row + j * channels, row + (j + 1) * channels, row + (width - 1 - j) * channels);
+    }
+}
+
+// A quarter turn of a square moves pixels in cycles of four:
+// (i, j) -> (j, n-1-i) -> (n-1-i, n-1-j) -> (n-1-j, i) for clockwise. One
+// cycle starts at each pixel of the top-left quadrant; walking that
+// quadrant in tiles keeps the four tiles a step touches in cache.
+template <typename T>
+static void turnSquareInPlace(T *pixels, size_t n, size_t stride, bool clockwise)
+{
+    size_t quadrantRows = n / 2;
+    size_t quadrantCols = (n + 1) / 2;
+    for (size_t i0 = 0; i0 < quadrantRows; i0 += REORIENT_TILE)
+    {
+        size_t iEnd = min(quadrantRows, i0 + REORIENT_TILE);
+        for (size_t j0 = 0; j0 < quadrantCols; j0 += REORIENT_TILE)
+        {
+            size_t jEnd = min(quadrantCols, j0 + REORIENT_TILE);
+            for (size_t i = i0; i < iEnd; ++i)
+            {
+                for (size_t j = j0; j < jEnd; ++j)
+                {
+                    T &a = pixels[i * stride + j];
+                    T &b = pixels[j * stride + n - 1 - i];
+                    T &c = pixels[(n - 1 - i) * stride + n - 1 - j];
+                    T &d = pixels[(n - 1 - j) * stride + i];
+                    T first = a;
+                    if (clockwise)
+                    {
+                        a = d;
+                        d = c;
+                        c = b;
+                        b = first;
+                    }
+                    else
+                    {
+                        a = b;
+                        b = c;
+                        c = d;
+                        d = first;
+                    }
+                }
+            }
+        }
+    }
+}
+
+template <typename T>
+void Image<T>::throwPendingOrientation()
+{
+    throw logic_error("Image has a pending orientation; materialize() it before reading through a const Image");
+}
+
+template <typename T>
+void Image<T>::materialize()
+{
+    if (pending.isIdentity())
+    {
+        return;
+    }
+    size_t width = metadata.width;
+    size_t height = metadata.height;
+    size_t channels = metadata.channels;
+
+    // Even turns keep the geometry: a half turn reverses the row order and
+    // each row, a mirror reverses each row again. Odd turns of a square
+    // grey image are done as a mirror plus in-place cycles.
+    bool inPlace = !pending.swapsAxes() || (width == height && channels == 1);
+    if (inPlace)
+    {
+        bool halfTurn = pending.quarterTurns == 2;
+        if (pending.mirrored != halfTurn)
+        {
+            for (size_t i = 0; i < height; ++i)
+            {
+                reversePixels(pixels.data() + i * rowStride, width, channels);
+            }
+        }
+        if (halfTurn)
+        {
+            for (size_t i = 0; i < height / 2; ++i)
+            {
+                swap_ranges(pixels.data() + i * rowStride, pixels.data() + i * rowStride + width * channels,
+                            pixels.data() + (height - 1 - i) * rowStride);
+            }
+        }
+        else if (pending.swapsAxes())
+        {
+            turnSquareInPlace(pixels.data(), width, rowStride, pending.quarterTurns == 1);
+        }
+        pending = Orientation();
+        return;
+    }
+
+    // Otherwise gather into a buffer of the new geometry, tile by tile.
+    OrientedLayout layout = orientedLayout();
+    size_t stride = alignedStride(width * channels);
+    vector<T, AlignedAllocator<T>> reoriented(stride * height);
+    const T *stored = pixels.data() + layout.origin;
+    for (size_t i0 = 0; i0 < height; i0 += REORIENT_TILE)
+    {
+        size_t iEnd = min(height, i0 + REORIENT_TILE);
+        for (size_t j0 = 0; j0 < width; j0 += REORIENT_TILE)
+        {
+            size_t jEnd = min(width, j0 + REORIENT_TILE);
+            for (size_t i = i0; i < iEnd; ++i)
+            {
+                T *out = reoriented.data() + i * stride;
+                const T *in = stored + static_cast<ptrdiff_t>(i) * layout.rowStep;
+                for (size_t j = j0; j < jEnd; ++j)
+                {
+                    const T *pixel = in + static_cast<ptrdiff_t>(j) * layout.pixelStep;
+                    copy(pixel, pixel + channels, out + j * channels);
+                }
+            }
+        }
+    }
+    pixels.swap(reoriented);
+    rowStride = stride;
+    pending = Orientation();
+}
+
+template <typename T>
+Image<T> copyImage(const ImageView<const T> &view)
+{
+    Image<T> image(view.width(), view.height(), view.channels());
+    copyPixels(view, image.view());
+    return image;
+}
+
+template <typename T>
+void copyPixels(const ImageView<const T> &src, const ImageView<T> &dst)
+{
+    if (src.width() != dst.width() || src.height() != dst.height() || src.channels() != dst.channels())
+    {
+        throw invalid_argument("Image dimensions do not match");
+    }
+    size_t rowBytes = src.rowLength() * sizeof(T);
+    for (uint32_t y = 0; y < src.height(); ++y)
+    {
+        memcpy(dst.row(y), src.row(y), rowBytes);
+    }
+}
+
+// Reverses the order of the T lanes packed in a 64-bit word: a byte swap,
+// then for wider lanes the bytes within each lane put back in order.
+template <typename T>
+static inline uint64_t reverseLanes(uint64_t word)
+{
+    if (sizeof(T) == 8)
+    {
+        return word;
+    }
+    word = __builtin_bswap64(word);
+    if (sizeof(T) >= 2)
+    {
+        word = ((word >> 8) & 0x00FF00FF00FF00FFull) | ((word & 0x00FF00FF00FF00FFull) << 8);
+    }
+    if (sizeof(T) == 4)
+    {
+        word = ((word >> 16) & 0x0000FFFF0000FFFFull) | ((word & 0x0000FFFF0000FFFFull) << 16);
+    }
+    return word;
+}
+
+template <typename T>
+void reverseSamples(T *samples, size_t count)
+{
+    // Eight bytes from each end per step, reversed in registers and stored
+    // crosswise; what is left in the middle is reversed sample by sample.
+    const size_t lanes = sizeof(uint64_t) / sizeof(T);
+    size_t left = 0;
+    size_t right = count;
+    while (right - left >= 2 * lanes)
+    {
+        uint64_t head, tail;
+        memcpy(&head, samples + left, sizeof(head));
+        memcpy(&tail, samples + right - lanes, sizeof(tail));
+        head = reverseLanes<T>(head);
+        tail = reverseLanes<T>(tail);
+        memcpy(samples + left, &tail, sizeof(tail));
+        memcpy(samples + right - lanes, &head, sizeof(head));
+        left += lanes;
+        right -= lanes;
+    }
+    reverse(samples + left, samples + right);
+}
 
 template <typename T>
 ImageStatus validateImage(const Image<T> &image)
 {
-    if (image.pixelData.empty() || image.metadata.width == 0 || image.metadata.height == 0)
+    if (image.empty() || image.metadata.width == 0 || image.metadata.height == 0)
     {
         return ImageStatus::UNSUPPORTED_FORMAT;
     }
     return ImageStatus::SUCCESS;
 }
 
+template Image<uint8_t> copyImage<uint8_t>(const ImageView<const uint8_t> &);
+template Image<uint16_t> copyImage<uint16_t>(const ImageView<const uint16_t> &);
+template Image<uint32_t> copyImage<uint32_t>(const ImageView<const uint32_t> &);
+template Image<uint64_t> copyImage<uint64_t>(const ImageView<const uint64_t> &);
+template Image<float> copyImage<float>(const ImageView<const float> &);
+template Image<double> copyImage<double>(const ImageView<const double> &);
+
+template void copyPixels<uint8_t>(const ImageView<const uint8_t> &, const ImageView<uint8_t> &);
+template void copyPixels<uint16_t>(const ImageView<const uint16_t> &, const ImageView<uint16_t> &);
+template void copyPixels<uint32_t>(const ImageView<const uint32_t> &, const ImageView<uint32_t> &);
+template void copyPixels<uint64_t>(const ImageView<const uint64_t> &, const ImageView<uint64_t> &);
+template void copyPixels<float>(const ImageView<const float> &, const ImageView<float> &);
+template void copyPixels<double>(const ImageView<const double> &, const ImageView<double> &);
+
+template void reverseSamples<uint8_t>(uint8_t *, size_t);
+template void reverseSamples<uint16_t>(uint16_t *, size_t);
+template void reverseSamples<uint32_t>(uint32_t *, size_t);
+template void reverseSamples<uint64_t>(uint64_t *, size_t);
+template void reverseSamples<float>(float *, size_t);
+template void reverseSamples<double>(double *, size_t);
+
+template ImageStatus validateImage<uint8_t>(const Image<uint8_t> &);
+template ImageStatus validateImage<uint16_t>(const Image<uint16_t> &);
+template ImageStatus validateImage<uint32_t>(const Image<uint32_t> &);
+template ImageStatus validateImage<uint64_t>(const Image<uint64_t> &);
+
 #endif // IMAGE_CPP
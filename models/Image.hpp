@@ -5,12 +5,16 @@
 #include <string>
 #include <cstdint>
 #include "ImageStatus.hpp"
+#include "ImageView.hpp"
+#include "Orientation.hpp"
+#include "AlignedAllocator.hpp"
 using namespace std;
 
 enum class ImageFormat
 {
     UNKNOWN,
     PGM,
+    PBM,
     PNG,
     JPEG,
     BMP
@@ -22,16 +26,102 @@ struct ImageMetadata
     uint32_t width = 0;
     uint32_t height = 0;
     uint32_t maxValue = 0;
+    uint32_t channels = 1;
 };
 
+// Where the pixels of a reoriented image sit in its stored buffer, in
+// samples: pixel (y, x) starts at origin + y * rowStep + x * pixelStep.
+struct OrientedLayout
+{
+    ptrdiff_t origin = 0;
+    ptrdiff_t rowStep = 0;
+    ptrdiff_t pixelStep = 0;
+};
+
+// Owning image: one aligned contiguous buffer, rows padded to a cache-line
+// multiple. Access pixels through view() / row(); allocate() keeps
+// metadata.width/height/channels in sync with the buffer geometry.
+//
+// Flips and quarter turns can be applied lazily with reorient(): metadata
+// changes at once, the stored pixels stay put, and the first pixel access
+// through a non-const Image (row, view, cview, stride) moves them, once,
+// for the whole chain. Const access never writes: it throws logic_error
+// while an orientation is pending, so concurrent readers of a const Image
+// stay safe. Readers that must not materialize can use storedView() and
+// orientedLayout() instead.
 template <typename T = uint8_t>
 struct Image
 {
     ImageMetadata metadata;
-    vector<T> pixelData;           // Flat array (if you just want the matrix)
-    vector<vector<T>> pixelMatrix; // 2D pixel array
+
+    Image() = default;
+    Image(uint32_t width, uint32_t height, uint32_t channels = 1);
+
+    // (Re)allocates a zero-filled buffer of the given geometry.
+    void allocate(uint32_t width, uint32_t height, uint32_t channels = 1);
+    void clear();
+
+    bool empty() const { return pixels.empty(); }
+    size_t stride() { settle(); return rowStride; }
+    size_t stride() const { requireSettled(); return rowStride; }
+
+    T *row(uint32_t y) { settle(); return pixels.data() + y * rowStride; }
+    const T *row(uint32_t y) const { requireSettled(); return pixels.data() + y * rowStride; }
+
+    ImageView<T> view() { settle(); return ImageView<T>(pixels.data(), metadata.width, metadata.height, rowStride, metadata.channels); }
+    ImageView<const T> view() const { return cview(); }
+    ImageView<const T> cview() { settle(); return static_cast<const Image &>(*this).cview(); }
+    ImageView<const T> cview() const { requireSettled(); return ImageView<const T>(pixels.data(), metadata.width, metadata.height, rowStride, metadata.channels); }
+
+    // Composes `change` after the pending orientation in O(1); width and
+    // height in metadata swap for odd quarter turns.
+    void reorient(const Orientation &change);
+    // Orientation still to be applied to the stored pixels.
+    const Orientation &orientation() const { return pending; }
+    // The buffer as stored, before the pending orientation.
+    ImageView<const T> storedView() const;
+    OrientedLayout orientedLayout() const;
+    // Applies the pending orientation to the pixels.
+    void materialize();
+
+    // Row stride (in elements) used for a row of `rowLength` samples.
+    static size_t alignedStride(size_t rowLength);
+
+private:
+    void settle()
+    {
+        if (!pending.isIdentity())
+        {
+            materialize();
+        }
+    }
+    void requireSettled() const
+    {
+        if (!pending.isIdentity())
+        {
+            throwPendingOrientation();
+        }
+    }
+    [[noreturn]] static void throwPendingOrientation();
+
+    vector<T, AlignedAllocator<T>> pixels;
+    size_t rowStride = 0;
+    Orientation pending;
 };
 
+// Deep copy of a (possibly strided) view into a freshly allocated image.
+template <typename T = uint8_t>
+Image<T> copyImage(const ImageView<const T> &view);
+
+// Copies `src` into `dst`; both must have the same geometry.
+template <typename T = uint8_t>
+void copyPixels(const ImageView<const T> &src, const ImageView<T> &dst);
+
+// Reverses `count` consecutive samples in place, eight bytes from each end
+// at a time.
+template <typename T = uint8_t>
+void reverseSamples(T *samples, size_t count);
+
 template <typename T = uint8_t>
 ImageStatus validateImage(const Image<T> &image);
 
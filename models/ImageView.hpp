@@ -0,0 +1,62 @@
+#ifndef IMAGE_VIEW_HPP
+#define IMAGE_VIEW_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+using namespace std;
+
+// Non-owning window onto strided pixel storage.
+// Rows are `stride` elements apart; each pixel holds `channels` interleaved
+// samples. Use ImageView<const T> for read-only access.
+template <typename T = uint8_t>
+class ImageView
+{
+public:
+    ImageView() = default;
+    ImageView(T *data, uint32_t width, uint32_t height, size_t stride, uint32_t channels = 1)
+        : pixels(data), viewWidth(width), viewHeight(height), rowStride(stride), numChannels(channels) {}
+
+    // A mutable view converts implicitly to a read-only one.
+    template <typename U, typename = enable_if_t<is_same<const U, T>::value && !is_same<U, T>::value>>
+    ImageView(const ImageView<U> &other)
+        : pixels(other.data()), viewWidth(other.width()), viewHeight(other.height()),
+          rowStride(other.stride()), numChannels(other.channels()) {}
+
+    T *data() const { return pixels; }
+    uint32_t width() const { return viewWidth; }
+    uint32_t height() const { return viewHeight; }
+    uint32_t channels() const { return numChannels; }
+    size_t stride() const { return rowStride; }
+    bool empty() const { return pixels == nullptr || viewWidth == 0 || viewHeight == 0; }
+
+    // Samples per row that actually belong to the image (excludes stride padding).
+    size_t rowLength() const { return static_cast<size_t>(viewWidth) * numChannels; }
+
+    T *row(uint32_t y) const { return pixels + y * rowStride; }
+    T &operator()(uint32_t y, uint32_t x, uint32_t c = 0) const
+    {
+        return pixels[y * rowStride + static_cast<size_t>(x) * numChannels + c];
+    }
+
+    // Region of interest sharing the same storage.
+    ImageView subView(uint32_t x, uint32_t y, uint32_t width, uint32_t height) const
+    {
+        if (x > viewWidth || y > viewHeight || width > viewWidth - x || height > viewHeight - y)
+        {
+            throw out_of_range("Sub-view exceeds image bounds");
+        }
+        return ImageView(pixels + y * rowStride + static_cast<size_t>(x) * numChannels,
+                         width, height, rowStride, numChannels);
+    }
+
+private:
+    T *pixels = nullptr;
+    uint32_t viewWidth = 0;
+    uint32_t viewHeight = 0;
+    size_t rowStride = 0;
+    uint32_t numChannels = 1;
+};
+
+#endif // IMAGE_VIEW_HPP
@@ -0,0 +1,80 @@
+#ifndef ORIENTATION_HPP
+#define ORIENTATION_HPP
+
+#include <cstdint>
+#include <utility>
+using namespace std;
+
+// One of the eight ways to lay a rectangle back onto its own outline: an
+// optional left-right mirror followed by `quarterTurns` clockwise quarter
+// turns. Any chain of flips and 90-degree rotations collapses to one of
+// these, so composing them never needs to touch a pixel.
+struct Orientation
+{
+    uint8_t quarterTurns = 0;
+    bool mirrored = false;
+
+    static Orientation rotatedClockwise(int quarterTurns)
+    {
+        Orientation orientation;
+        orientation.quarterTurns = static_cast<uint8_t>(((quarterTurns % 4) + 4) % 4);
+        return orientation;
+    }
+    static Orientation mirroredHorizontally()
+    {
+        Orientation orientation;
+        orientation.mirrored = true;
+        return orientation;
+    }
+    // Top-bottom mirror = left-right mirror, then a half turn.
+    static Orientation mirroredVertically()
+    {
+        Orientation orientation;
+        orientation.quarterTurns = 2;
+        orientation.mirrored = true;
+        return orientation;
+    }
+
+    bool isIdentity() const { return quarterTurns == 0 && !mirrored; }
+    // Odd quarter turns exchange width and height.
+    bool swapsAxes() const { return quarterTurns % 2 == 1; }
+
+    // This orientation followed by `next`. A mirror reverses the sense of
+    // the turns made before it: M * R^k = R^-k * M.
+    Orientation then(const Orientation &next) const
+    {
+        Orientation combined;
+        int turns = next.mirrored ? next.quarterTurns - quarterTurns : next.quarterTurns + quarterTurns;
+        combined.quarterTurns = static_cast<uint8_t>(((turns % 4) + 4) % 4);
+        combined.mirrored = mirrored != next.mirrored;
+        return combined;
+    }
+
+    // Stored position (row, column) of pixel (y, x) of the reoriented
+    // width x height image. The map is affine, so it also holds (and gives
+    // per-step deltas) for coordinates just outside the image.
+    pair<int64_t, int64_t> sourceOf(int64_t width, int64_t height, int64_t y, int64_t x) const
+    {
+        for (int k = 0; k < quarterTurns; k++)
+        {
+            // Undo one clockwise turn: (y, x) came from (width - 1 - x, y).
+            int64_t row = width - 1 - x;
+            x = y;
+            y = row;
+            swap(width, height);
+        }
+        if (mirrored)
+        {
+            x = width - 1 - x;
+        }
+        return make_pair(y, x);
+    }
+
+    bool operator==(const Orientation &other) const
+    {
+        return quarterTurns == other.quarterTurns && mirrored == other.mirrored;
+    }
+    bool operator!=(const Orientation &other) const { return !(*this == other); }
+};
+
+#endif // ORIENTATION_HPP
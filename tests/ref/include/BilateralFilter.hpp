@@ -5,18 +5,36 @@
 #include <cmath>
 #include <algorithm>
 #include <cstdint>
+#include "Image.hpp"
 
+// Edge-preserving smoothing of a single-channel image. Spatial weights are
+// tabulated once per call for the kernel and range weights once per
+// absolute intensity difference, so the per-tap work is two lookups and a
+// multiply whatever the pixel type.
+template <typename T = uint8_t>
 class BilateralFilter {
 public:
-    static std::vector<std::vector<uint8_t>> apply(
-        const std::vector<std::vector<uint8_t>>& image,
+    static Image<T> apply(
+        const ImageView<const T>& image,
         int kernelSize,
         double sigmaSpatial,        // for  Euclidean distances.
         double sigmaIntensity       // for intensity differences.
     );
+    // Approximation on a bilateral grid: the image is splatted into a
+    // volume sampled every sigmaSpatial pixels and every sigmaIntensity
+    // levels, blurred there and sliced back out by trilinear interpolation.
+    // The cost per pixel does not depend on sigmaSpatial; the spatial
+    // Gaussian approximated is the untruncated one. On barb.512.pgm with
+    // sigma_s 3, sigma_r 15 the result is above 50 dB PSNR against apply()
+    // with a 19 x 19 kernel (filters_test checks this).
+    static Image<T> applyGrid(
+        const ImageView<const T>& image,
+        double sigmaSpatial,
+        double sigmaIntensity
+    );
 
 private:
     static double gaussian(double x, double sigma);
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,27 @@
+#ifndef BINARYMORPHOLOGY_HPP
+#define BINARYMORPHOLOGY_HPP
+
+#include "BinaryImage.hpp"
+
+using namespace std;
+
+// Morphology<T> for packed masks: a width x height rectangle (odd sides,
+// centred), with pixels outside the mask never winning, so the results are
+// those of Morphology<uint8_t> on a 0/1 image.
+//
+// Everything runs on whole words, 64 pixels per operation. Along a row, a
+// window of w bits is grown by doubling: OR-ing (or AND-ing) the row with
+// itself shifted by 1, 2, 4, ... bits covers 2^k pixels in k steps, and one
+// more shifted copy tops it up to w. Columns are grown the same way with
+// whole rows instead of bit shifts. The cost is O(log w + log h) word
+// operations per 64 pixels.
+class BinaryMorphology
+{
+public:
+    static BinaryImage erode(const BinaryImage &mask, int width, int height);
+    static BinaryImage dilate(const BinaryImage &mask, int width, int height);
+    static BinaryImage open(const BinaryImage &mask, int width, int height);
+    static BinaryImage close(const BinaryImage &mask, int width, int height);
+};
+
+#endif // BINARYMORPHOLOGY_HPP
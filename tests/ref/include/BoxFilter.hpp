@@ -6,6 +6,8 @@
 #include <cmath>
 #include "FFT.hpp"
 #include "Complex.hpp"
+#include "Image.hpp"
+#include "Convolution.hpp"
 #include <cstdint>
 using namespace std;
 
@@ -13,11 +15,23 @@ template <typename T = uint8_t>
 class BoxFilter
 {
 public:
-    static vector<vector<T>> applyBoxFilterFFT(
-        const vector<vector<T>> &image, int kernelSize);
-    static vector<vector<T>> applyBoxFilterSlidingGrey(
-        const vector<vector<T>> &inputImg, int kernelSize);
-    static vector<vector<vector<T>>> applyBoxFilterSlidingRGB(
-        const vector<vector<vector<T>>> &inputImg, int kernelSize);
+    static Image<T> applyBoxFilterFFT(
+        const ImageView<const T> &image, int kernelSize);
+    // Running-sum box filters: the cost per pixel is the same for any odd
+    // kernelSize.
+    static Image<T> applyBoxFilterSlidingGrey(
+        const ImageView<const T> &inputImg, int kernelSize);
+    // inputImg holds interleaved samples (inputImg.channels() per pixel).
+    static Image<T> applyBoxFilterSlidingRGB(
+        const ImageView<const T> &inputImg, int kernelSize);
+    // Same output as applyBoxFilterFFT, from a summed-area table. To try
+    // several kernel sizes, build one IntegralImage and call its boxFilter.
+    static Image<T> applyBoxFilterIntegral(
+        const ImageView<const T> &image, int kernelSize);
+    // Direct separable convolution through Convolution<T>, rounded once,
+    // for any border mode. O(kernelSize) per pixel; with a zero border the
+    // running-sum and integral versions are faster.
+    static Image<T> applyBoxFilterDirect(
+        const ImageView<const T> &image, int kernelSize, BorderMode border = BorderMode::ZERO);
 };
 #endif // BOXFILTER_HPP
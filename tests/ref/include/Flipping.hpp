@@ -24,11 +24,15 @@ class ImageFlipper
 {
 
 public:
+    // Composes the flip into the image's orientation; pixels move on the
+    // next access (see Image::reorient).
     static void flip(Image<T> &image, const FlippingDirection direction);
+    // Flips the pixels of `view` in place (any ROI of a larger image).
+    static void flip(const ImageView<T> &view, const FlippingDirection direction);
 
 private:
-    static void flipVertical(vector<vector<T>> &matrix);
-    static void flipHorizontal(vector<vector<T>> &matrix);
+    static void flipVertical(const ImageView<T> &view);
+    static void flipHorizontal(const ImageView<T> &view);
 };
 
 #endif // FLIPPING_HPP
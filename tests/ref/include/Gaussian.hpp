@@ -2,31 +2,73 @@
 #define GAUSSIANFILTER_HPP
 
 #include <vector>
+#include <memory>
 #include <cstdint>
+#include "Image.hpp"
+#include "Convolution.hpp"
 using namespace std;
 
+// How the taps of a Gaussian kernel are computed: the density at each tap
+// centre, or its integral over the pixel (a difference of erf values).
+enum class GaussianKernelMode
+{
+    SAMPLED,
+    INTEGRATED
+};
+
+// Normalized 1D and 2D Gaussian kernels, built once per (kernelSize, sigma,
+// mode) and shared process-wide; safe to call from several threads. The 2D
+// kernel is the outer product of the 1D one. kernelSize must be odd and
+// sigma positive.
+shared_ptr<const vector<double>> cachedGaussianKernel1D(int kernelSize, double sigma, GaussianKernelMode mode);
+shared_ptr<const vector<vector<double>>> cachedGaussianKernel2D(int kernelSize, double sigma, GaussianKernelMode mode);
+
 // Generates a normalized 2D Gaussian kernel.
 // The kernel is represented as a 2D vector of doubles.
 // The kernel size must be an odd number.
-vector<vector<double>> generateGaussianKernel(int kernelSize, double sigma);
+vector<vector<double>> generateGaussianKernel(int kernelSize, double sigma,
+                                              GaussianKernelMode mode = GaussianKernelMode::INTEGRATED);
 
 // Applies a Gaussian filter (convolution) to the input image.
-// The image is represented as a 2D vector of uint8_t (grayscale values).
+// The image is a read-only grayscale view (see Image<T>::cview()).
+// Any kernel is accepted and run through Convolution<T>::convolve, which
+// uses separable passes when the kernel is (nearly) low rank. Results are
+// truncated; see Convolution<T> for the border modes.
 template <typename T = uint8_t>
-vector<vector<T>> applyGaussianFilter(
-    const vector<vector<T>> &image,
-    const vector<vector<double>> &kernel);
+Image<T> applyGaussianFilter(
+    const ImageView<const T> &image,
+    const vector<vector<double>> &kernel,
+    BorderMode border = BorderMode::ZERO);
 
 // Padding the image for convolution
 template <typename T = uint8_t>
-vector<vector<T>> zeroPad(const vector<vector<T>> &image, int padSize);
+Image<T> zeroPad(const ImageView<const T> &image, int padSize);
 
 // Generates a 1D Gaussian kernel.
-vector<double> generateGaussianKernel1D(int kernelSize, double sigma);
+vector<double> generateGaussianKernel1D(int kernelSize, double sigma,
+                                        GaussianKernelMode mode = GaussianKernelMode::SAMPLED);
 
 // Applies a separable Gaussian filter to the input image.
 template <typename T = uint8_t>
-vector<vector<T>> applyGaussianFilterSeparable(
-    const vector<vector<T>> &image, int kernelSize, double sigma);
+Image<T> applyGaussianFilterSeparable(
+    const ImageView<const T> &image, int kernelSize, double sigma,
+    BorderMode border = BorderMode::ZERO);
+
+// Separable Gaussian in fixed point, for 8- and 16-bit images only. The 1D
+// kernel is quantized to Q15 (8-bit) or Q16 (16-bit) weights that sum to
+// exactly one, the intermediate image is 16 bits per pixel (8 fractional
+// bits for 8-bit input) and all accumulation is in 32-bit integers. The
+// output is rounded to nearest rather than truncated. Borders are zero.
+template <typename T = uint8_t>
+Image<T> applyGaussianFilterFixedPoint(
+    const ImageView<const T> &image, int kernelSize, double sigma);
+
+// Recursive (IIR) Gaussian filter of Young and van Vliet: a third-order
+// causal and anti-causal recursion along rows, then along columns. The cost
+// per pixel is the same for any sigma (>= 0.5); borders are zero, as in
+// applyGaussianFilterSeparable with an untruncated kernel.
+template <typename T = uint8_t>
+Image<T> applyGaussianFilterRecursive(
+    const ImageView<const T> &image, double sigma);
 
 #endif // GAUSSIANFILTER_H
@@ -0,0 +1,44 @@
+#ifndef MEDIANFILTER_HPP
+#define MEDIANFILTER_HPP
+
+#include "Image.hpp"
+#include "ThreadPool.hpp"
+#include <cstdint>
+
+using namespace std;
+
+// Median of the kernelSize x kernelSize window around each pixel of a
+// single-channel 8- or 16-bit image. Windows reaching past the edges see
+// the edge samples replicated outward, so borders are not pulled toward
+// black. Rows are shared out over `pool`; results do not depend on the
+// thread count.
+template <typename T = uint8_t>
+class MedianFilter
+{
+public:
+    // Sorting networks for 3 x 3 and 5 x 5 windows, the histogram method
+    // for anything larger.
+    static Image<T> apply(const ImageView<const T> &image, int kernelSize,
+                          ThreadPool &pool = ThreadPool::shared());
+
+    // Perreault and Hebert's constant-time median: one histogram per column
+    // slides down the image, and the window histogram slides along a row by
+    // adding the column entering it and subtracting the one leaving. Both
+    // are kept at two levels, a coarse histogram of the high half of the
+    // bits and a fine one of all of them; only the coarse level is updated
+    // for every pixel, and the fine counts of a coarse bin are brought up to
+    // date when the median next falls in it. The cost per pixel does not
+    // depend on kernelSize. 16-bit images are processed in vertical stripes
+    // so the fine column histograms stay a bounded size.
+    static Image<T> applyHistogram(const ImageView<const T> &image, int kernelSize,
+                                   ThreadPool &pool = ThreadPool::shared());
+
+    // Selection networks of 19 (3 x 3) and 99 (5 x 5) compare-exchanges
+    // from Devillard's "Fast median search", each run across a strip of
+    // pixels at a time so the min/max pairs vectorize. kernelSize must be 3
+    // or 5.
+    static Image<T> applySortingNetwork(const ImageView<const T> &image, int kernelSize,
+                                        ThreadPool &pool = ThreadPool::shared());
+};
+
+#endif // MEDIANFILTER_HPP
@@ -0,0 +1,46 @@
+#ifndef MORPHOLOGY_HPP
+#define MORPHOLOGY_HPP
+
+#include "Image.hpp"
+#include "ThreadPool.hpp"
+#include <cstdint>
+
+using namespace std;
+
+// Grey-level morphology with a flat width x height rectangle (odd sides,
+// centred on the pixel). Samples outside the image never win: erosion
+// treats them as the largest value of T and dilation as zero. Interleaved
+// channels are processed independently.
+//
+// Each operator runs as a horizontal and a vertical van Herk / Gil-Werman
+// pass: the line is cut into blocks as long as the element, running minima
+// (or maxima) are taken forward and backward within each block, and every
+// window is the combination of one backward value and one forward value.
+// That is three comparisons per sample and pass whatever the element size.
+// Rows and column strips are shared out over `pool`; results do not depend
+// on the thread count.
+template <typename T = uint8_t>
+class Morphology
+{
+public:
+    // Minimum over the rectangle.
+    static Image<T> erode(const ImageView<const T> &image, int width, int height,
+                          ThreadPool &pool = ThreadPool::shared());
+    // Maximum over the rectangle.
+    static Image<T> dilate(const ImageView<const T> &image, int width, int height,
+                           ThreadPool &pool = ThreadPool::shared());
+    // Erosion then dilation: removes bright detail smaller than the element.
+    static Image<T> open(const ImageView<const T> &image, int width, int height,
+                         ThreadPool &pool = ThreadPool::shared());
+    // Dilation then erosion: fills dark detail smaller than the element.
+    static Image<T> close(const ImageView<const T> &image, int width, int height,
+                          ThreadPool &pool = ThreadPool::shared());
+    // image - open(image): the bright detail opening removed.
+    static Image<T> topHat(const ImageView<const T> &image, int width, int height,
+                           ThreadPool &pool = ThreadPool::shared());
+    // close(image) - image: the dark detail closing filled.
+    static Image<T> blackTopHat(const ImageView<const T> &image, int width, int height,
+                                ThreadPool &pool = ThreadPool::shared());
+};
+
+#endif // MORPHOLOGY_HPP
@@ -22,12 +22,17 @@ template <typename T = uint8_t>
 class ImageRotator
 {
 public:
+    // Composes the turn into the image's orientation in O(1); the pixels
+    // move once, on the next access (see Image::reorient).
     static void rotate(Image<T> &image, RotationDirection direction);
+    // Writes the rotated `src` into `dst`, which must already have the
+    // rotated geometry (width and height swapped for 90-degree turns).
+    static void rotate(const ImageView<const T> &src, const ImageView<T> &dst, RotationDirection direction);
 
 private:
-    static void rotate90CW(vector<vector<T>> &matrix);
-    static void rotate90CCW(vector<vector<T>> &matrix);
-    static void rotate180(vector<vector<T>> &matrix);
+    static void rotate90CW(const ImageView<const T> &src, const ImageView<T> &dst);
+    static void rotate90CCW(const ImageView<const T> &src, const ImageView<T> &dst);
+    static void rotate180(const ImageView<T> &image);
 };
 
 #endif // ROTATION_HPP
@@ -0,0 +1,71 @@
+#ifndef WARP_HPP
+#define WARP_HPP
+
+#include "Image.hpp"
+#include "Convolution.hpp"
+#include "ThreadPool.hpp"
+#include <cstdint>
+#include <utility>
+
+using namespace std;
+
+enum class Interpolation
+{
+    NEAREST,
+    BILINEAR,
+    BICUBIC
+};
+
+// Affine map of the plane, x' = a x + b y + c and y' = d x + e y + f, in
+// pixel coordinates: pixel (i, j) is centred on x = j, y = i, with y
+// pointing down the image.
+struct AffineTransform
+{
+    double a = 1.0, b = 0.0, c = 0.0;
+    double d = 0.0, e = 1.0, f = 0.0;
+
+    static AffineTransform translation(double dx, double dy);
+    // Turn by `degrees` about (centreX, centreY), clockwise as seen on
+    // screen like RotationDirection::CW_90.
+    static AffineTransform rotation(double degrees, double centreX, double centreY);
+    static AffineTransform scaling(double scaleX, double scaleY, double centreX = 0.0, double centreY = 0.0);
+    // x' = x + shearX (y - centreY), y' = y + shearY (x - centreX).
+    static AffineTransform shear(double shearX, double shearY, double centreX = 0.0, double centreY = 0.0);
+
+    // This transform followed by `next`.
+    AffineTransform then(const AffineTransform &next) const;
+    // Throws invalid_argument for a singular transform.
+    AffineTransform inverse() const;
+    pair<double, double> apply(double x, double y) const { return make_pair(a * x + b * y + c, d * x + e * y + f); }
+};
+
+// Resamples an image through an affine transform: output pixel (i, j)
+// takes the input at transform.inverse().apply(j, i), read with the chosen
+// interpolation (bicubic is Keys' a = -0.5 kernel, clamped to the range of
+// T). Taps outside the input go through `border`; ZERO reads them as 0.
+// Interleaved channels are resampled independently.
+//
+// The output is cut into 256 x 32 tiles shared out over `pool`, so the
+// input a tile reads stays in cache whatever the angle. Within a tile row
+// the input position is not recomputed from the matrix: it starts from
+// the exact position of the row's first pixel and steps by a constant
+// increment in 32.32 fixed point. 8-bit images take the interpolation
+// weights from tables indexed by the fraction rounded to 1/256 pixel (at
+// most half a level off); wider samples have them computed from the full
+// fraction. Results do not depend on the thread count.
+template <typename T = uint8_t>
+class ImageWarper
+{
+public:
+    static Image<T> warp(const ImageView<const T> &image, const AffineTransform &transform,
+                         uint32_t width, uint32_t height, Interpolation interpolation = Interpolation::BILINEAR,
+                         BorderMode border = BorderMode::ZERO, ThreadPool &pool = ThreadPool::shared());
+
+    // Turn by `degrees` about the image centre into an image of the same
+    // size, e.g. to deskew a scan.
+    static Image<T> rotate(const ImageView<const T> &image, double degrees,
+                           Interpolation interpolation = Interpolation::BILINEAR,
+                           BorderMode border = BorderMode::ZERO, ThreadPool &pool = ThreadPool::shared());
+};
+
+#endif // WARP_HPP
@@ -1,48 +1,291 @@
+#ifndef BILATERALFILTER_CPP
+#define BILATERALFILTER_CPP
+
 #include "BilateralFilter.hpp"
+#include <limits>
+#include <stdexcept>
+
+template class BilateralFilter<uint8_t>;
+template class BilateralFilter<uint16_t>;
+template class BilateralFilter<uint32_t>;
+template class BilateralFilter<uint64_t>;
+
+// Longest range-weight table built; wider intensity spreads with a sigma
+// large enough to need more entries compute the rest on the fly.
+static const size_t MAX_RANGE_TABLE = size_t(1) << 20;
+
+// Largest grid applyGrid will allocate, in cells.
+static const size_t MAX_GRID_CELLS = size_t(1) << 27;
+// Cells of padding on each side of the grid: the blur is five taps wide,
+// so nothing splatted inside spreads past the edge.
+static const size_t GRID_PADDING = 2;
 
+template <typename T>
+static void sampleRange(const ImageView<const T>& image, T& minValue, T& maxValue) {
+    minValue = image.row(0)[0];
+    maxValue = minValue;
+    for (uint32_t i = 0; i < image.height(); ++i) {
+        const T* row = image.row(i);
+        for (uint32_t j = 0; j < image.width(); ++j) {
+            minValue = std::min(minValue, row[j]);
+            maxValue = std::max(maxValue, row[j]);
+        }
+    }
+}
 
-double BilateralFilter::gaussian(double x, double sigma) {
+template <typename T>
+double BilateralFilter<T>::gaussian(double x, double sigma) {
     double xSquared = x * x;
     double sigmaSquared = sigma * sigma;
     return std::exp(-(xSquared) / (2 * sigmaSquared)) / (2 * M_PI * sigmaSquared);
 }
 
-std::vector<std::vector<uint8_t>> BilateralFilter::apply(
-    const std::vector<std::vector<uint8_t>>& image,
+template <typename T>
+Image<T> BilateralFilter<T>::apply(
+    const ImageView<const T>& image,
     int kernelSize,
     double sigmaSpatial,
     double sigmaIntensity
 ) {
-    int rows = image.size();
-    int cols = image[0].size();
-    std::vector<std::vector<uint8_t>> output(rows, std::vector<uint8_t>(cols, 0));
+    if (image.empty()) {
+        throw std::invalid_argument("Image is empty");
+    }
+    if (kernelSize < 1 || kernelSize % 2 == 0) {
+        throw std::invalid_argument("Invalid kernel size");
+    }
+    if (!(sigmaSpatial > 0) || !(sigmaIntensity > 0)) {
+        throw std::invalid_argument("Sigma must be positive");
+    }
+
+    int rows = image.height();
+    int cols = image.width();
+    Image<T> output(cols, rows);
 
     int halfKernel = kernelSize / 2;
 
+    // Spatial weight of every tap, row-major over the kernel.
+    std::vector<double> spatialWeights(static_cast<size_t>(kernelSize) * kernelSize);
+    for (int ki = -halfKernel; ki <= halfKernel; ++ki) {
+        for (int kj = -halfKernel; kj <= halfKernel; ++kj) {
+            spatialWeights[(ki + halfKernel) * kernelSize + (kj + halfKernel)] =
+                gaussian(std::sqrt(ki * ki + kj * kj), sigmaSpatial);
+        }
+    }
+
+    // Range weight by |difference|, up to the largest difference present
+    // in the image. The table also stops at the first weight that
+    // underflows to zero: every larger difference contributes nothing.
+    T minValue, maxValue;
+    sampleRange(image, minValue, maxValue);
+    uint64_t largestDifference = static_cast<uint64_t>(maxValue - minValue);
+    std::vector<double> rangeWeights;
+    bool rangeExhausted = false;
+    for (uint64_t d = 0; d <= largestDifference && rangeWeights.size() < MAX_RANGE_TABLE; ++d) {
+        double weight = gaussian(static_cast<double>(d), sigmaIntensity);
+        if (weight == 0.0) {
+            rangeExhausted = true;
+            break;
+        }
+        rangeWeights.push_back(weight);
+    }
+    rangeExhausted = rangeExhausted || rangeWeights.size() > largestDifference;
+
+    const double largestSample = static_cast<double>(std::numeric_limits<T>::max());
     for (int i = 0; i < rows; ++i) {
+        // Only the taps that fall inside the image, in the same order as a
+        // full kernel sweep with a bounds test.
+        int firstKi = std::max(-halfKernel, -i);
+        int lastKi = std::min(halfKernel, rows - 1 - i);
+        T* outRow = output.row(i);
         for (int j = 0; j < cols; ++j) {
+            int firstKj = std::max(-halfKernel, -j);
+            int lastKj = std::min(halfKernel, cols - 1 - j);
+            T center = image.row(i)[j];
             double sumWeights = 0.0;
             double filteredValue = 0.0;
 
-            for (int ki = -halfKernel; ki <= halfKernel; ++ki) {
-                for (int kj = -halfKernel; kj <= halfKernel; ++kj) {
-                    int ni = i + ki;
-                    int nj = j + kj;
+            for (int ki = firstKi; ki <= lastKi; ++ki) {
+                const T* neighbours = image.row(i + ki) + j;
+                const double* spatialRow = spatialWeights.data() + (ki + halfKernel) * kernelSize + halfKernel;
+                for (int kj = firstKj; kj <= lastKj; ++kj) {
+                    T value = neighbours[kj];
+                    uint64_t difference = value > center ? static_cast<uint64_t>(value - center)
+                                                         : static_cast<uint64_t>(center - value);
+                    double intensityWeight;
+                    if (difference < rangeWeights.size())
+                        intensityWeight = rangeWeights[difference];
+                    else if (rangeExhausted)
+                        intensityWeight = 0.0;
+                    else
+                        intensityWeight = gaussian(static_cast<double>(difference), sigmaIntensity);
+                    double weight = spatialRow[kj] * intensityWeight;
+
+                    filteredValue += weight * value;
+                    sumWeights += weight;
+                }
+            }
+
+            // A weighted mean of 64-bit samples can round up to 2^64 in double.
+            double mean = filteredValue / sumWeights;
+            outRow[j] = mean >= largestSample ? std::numeric_limits<T>::max() : static_cast<T>(mean);
+        }
+    }
+
+    return output;
+}
+
+// Homogeneous grid cell: weighted sum of intensities and sum of weights.
+struct GridCell {
+    float value;
+    float weight;
+};
+
+// Convolves `count` cells spaced `step` apart with the binomial kernel
+// [1 4 6 4 1] / 16 (unit variance, in cells), zero outside.
+static void blurLine(GridCell* line, size_t count, size_t step, std::vector<GridCell>& scratch) {
+    scratch.assign(count + 4, GridCell{0.0f, 0.0f});
+    for (size_t n = 0; n < count; ++n) {
+        scratch[n + 2] = line[n * step];
+    }
+    for (size_t n = 0; n < count; ++n) {
+        const GridCell* s = scratch.data() + n;
+        line[n * step].value = (s[0].value + s[4].value + 4.0f * (s[1].value + s[3].value) + 6.0f * s[2].value) / 16.0f;
+        line[n * step].weight =
+            (s[0].weight + s[4].weight + 4.0f * (s[1].weight + s[3].weight) + 6.0f * s[2].weight) / 16.0f;
+    }
+}
+
+template <typename T>
+Image<T> BilateralFilter<T>::applyGrid(
+    const ImageView<const T>& image,
+    double sigmaSpatial,
+    double sigmaIntensity
+) {
+    if (image.empty()) {
+        throw std::invalid_argument("Image is empty");
+    }
+    if (!(sigmaSpatial > 0) || !(sigmaIntensity > 0)) {
+        throw std::invalid_argument("Sigma must be positive");
+    }
+
+    size_t rows = image.height();
+    size_t cols = image.width();
+    T minValue, maxValue;
+    sampleRange(image, minValue, maxValue);
+
+    // Splatting, the blur and slicing each spread a sample; their variances
+    // add up to GRID_SPREAD cells^2, so cells are made that much smaller than
+    // the sigmas to keep the overall spread at sigma.
+    const double GRID_SPREAD = 1.0 + 1.0 / 6.0 + 1.0 / 6.0;
+    double spatialStep = sigmaSpatial / std::sqrt(GRID_SPREAD);
+    double rangeStep = sigmaIntensity / std::sqrt(GRID_SPREAD);
+
+    // Every splat coordinate c has cells floor(c) and floor(c) + 1 in range.
+    size_t gridCols = static_cast<size_t>((cols - 1) / spatialStep) + 2 * GRID_PADDING + 2;
+    size_t gridRows = static_cast<size_t>((rows - 1) / spatialStep) + 2 * GRID_PADDING + 2;
+    double depthCells = static_cast<double>(maxValue - minValue) / rangeStep;
+    if (depthCells * gridCols * gridRows > static_cast<double>(MAX_GRID_CELLS)) {
+        throw std::invalid_argument("Bilateral grid too large: sigmas are too small for the image");
+    }
+    size_t gridDepth = static_cast<size_t>(depthCells) + 2 * GRID_PADDING + 2;
+    if (gridDepth * gridCols * gridRows > MAX_GRID_CELLS) {
+        throw std::invalid_argument("Bilateral grid too large: sigmas are too small for the image");
+    }
 
-                    if (ni >= 0 && ni < rows && nj >= 0 && nj < cols) {
-                        double spatialWeight = gaussian(std::sqrt(ki * ki + kj * kj), sigmaSpatial);
-                        double intensityWeight = gaussian(image[ni][nj] - image[i][j], sigmaIntensity);
-                        double weight = spatialWeight * intensityWeight;
+    // Cells are stored with intensity fastest, then x, then y.
+    size_t rowCells = gridCols * gridDepth;
+    std::vector<GridCell> grid(gridRows * rowCells, GridCell{0.0f, 0.0f});
 
-                        filteredValue += weight * image[ni][nj];
-                        sumWeights += weight;
-                    }
+    // Per-column grid coordinates are shared by every row.
+    std::vector<size_t> cellX(cols);
+    std::vector<float> fracX(cols);
+    for (size_t j = 0; j < cols; ++j) {
+        double x = j / spatialStep + GRID_PADDING;
+        cellX[j] = static_cast<size_t>(x);
+        fracX[j] = static_cast<float>(x - cellX[j]);
+    }
+    auto depthOf = [&](T v, size_t& cell, float& frac) {
+        double z = static_cast<double>(v - minValue) / rangeStep + GRID_PADDING;
+        cell = static_cast<size_t>(z);
+        frac = static_cast<float>(z - cell);
+    };
+
+    // Splat: each pixel is shared trilinearly between its eight cells.
+    for (size_t i = 0; i < rows; ++i) {
+        double y = i / spatialStep + GRID_PADDING;
+        size_t cy = static_cast<size_t>(y);
+        float fy = static_cast<float>(y - cy);
+        const T* row = image.row(i);
+        for (size_t j = 0; j < cols; ++j) {
+            size_t cz;
+            float fz;
+            depthOf(row[j], cz, fz);
+            float value = static_cast<float>(row[j]);
+            GridCell* base = grid.data() + cy * rowCells + cellX[j] * gridDepth + cz;
+            for (int dy = 0; dy < 2; ++dy) {
+                float wy = dy ? fy : 1.0f - fy;
+                for (int dx = 0; dx < 2; ++dx) {
+                    float wxy = wy * (dx ? fracX[j] : 1.0f - fracX[j]);
+                    GridCell* cell = base + dy * rowCells + dx * gridDepth;
+                    cell[0].value += wxy * (1.0f - fz) * value;
+                    cell[0].weight += wxy * (1.0f - fz);
+                    cell[1].value += wxy * fz * value;
+                    cell[1].weight += wxy * fz;
                 }
             }
+        }
+    }
+
+    // Blur along intensity, x and y.
+    std::vector<GridCell> scratch;
+    for (size_t line = 0; line < gridRows * gridCols; ++line) {
+        blurLine(grid.data() + line * gridDepth, gridDepth, 1, scratch);
+    }
+    for (size_t gy = 0; gy < gridRows; ++gy) {
+        for (size_t gz = 0; gz < gridDepth; ++gz) {
+            blurLine(grid.data() + gy * rowCells + gz, gridCols, gridDepth, scratch);
+        }
+    }
+    for (size_t offset = 0; offset < rowCells; ++offset) {
+        blurLine(grid.data() + offset, gridRows, rowCells, scratch);
+    }
 
-            output[i][j] = filteredValue / sumWeights;
+    // Slice: trilinear interpolation of both channels at each pixel's own
+    // coordinates, then normalisation. The mean is truncated like apply().
+    Image<T> output(cols, rows);
+    const double largestSample = static_cast<double>(std::numeric_limits<T>::max());
+    for (size_t i = 0; i < rows; ++i) {
+        double y = i / spatialStep + GRID_PADDING;
+        size_t cy = static_cast<size_t>(y);
+        float fy = static_cast<float>(y - cy);
+        const T* row = image.row(i);
+        T* outRow = output.row(i);
+        for (size_t j = 0; j < cols; ++j) {
+            size_t cz;
+            float fz;
+            depthOf(row[j], cz, fz);
+            const GridCell* base = grid.data() + cy * rowCells + cellX[j] * gridDepth + cz;
+            double value = 0.0;
+            double weight = 0.0;
+            for (int dy = 0; dy < 2; ++dy) {
+                float wy = dy ? fy : 1.0f - fy;
+                for (int dx = 0; dx < 2; ++dx) {
+                    float wxy = wy * (dx ? fracX[j] : 1.0f - fracX[j]);
+                    const GridCell* cell = base + dy * rowCells + dx * gridDepth;
+                    value += wxy * ((1.0f - fz) * cell[0].value + fz * cell[1].value);
+                    weight += wxy * ((1.0f - fz) * cell[0].weight + fz * cell[1].weight);
+                }
+            }
+            if (!(weight > 0.0)) {
+                outRow[j] = row[j];
+                continue;
+            }
+            double mean = std::max(0.0, value / weight);
+            outRow[j] = mean >= largestSample ? std::numeric_limits<T>::max() : static_cast<T>(mean);
         }
     }
 
     return output;
-}
\ No newline at end of file
+}
+
+#endif // BILATERALFILTER_CPP
@@ -0,0 +1,140 @@
+#ifndef BINARYMORPHOLOGY_CPP
+#define BINARYMORPHOLOGY_CPP
+
+#include "BinaryMorphology.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+// The word-wide operators; `fill` is their neutral word, what pixels
+// outside the mask read as.
+struct UnionOf
+{
+    static const uint64_t fill = 0;
+    uint64_t operator()(uint64_t a, uint64_t b) const { return a | b; }
+};
+
+struct IntersectionOf
+{
+    static const uint64_t fill = ~uint64_t(0);
+    uint64_t operator()(uint64_t a, uint64_t b) const { return a & b; }
+};
+
+// out bit x = in bit x + shift over a packed line, reading `fill` bits past
+// either end of `in`.
+static void shiftBits(const uint64_t *in, size_t inWords, ptrdiff_t shift, uint64_t fill, uint64_t *out,
+                      size_t outWords)
+{
+    const ptrdiff_t bits = BinaryImage::WORD_BITS;
+    ptrdiff_t wordShift = shift >= 0 ? shift / bits : -((bits - 1 - shift) / bits);
+    unsigned bitShift = static_cast<unsigned>(shift - wordShift * bits);
+    auto word = [&](ptrdiff_t j) { return j >= 0 && j < static_cast<ptrdiff_t>(inWords) ? in[j] : fill; };
+    for (size_t i = 0; i < outWords; i++)
+    {
+        ptrdiff_t j = static_cast<ptrdiff_t>(i) + wordShift;
+        out[i] = bitShift == 0 ? word(j) : (word(j) << bitShift) | (word(j + 1) >> (bits - bitShift));
+    }
+}
+
+template <typename Op>
+static BinaryImage shiftMorphology(const BinaryImage &mask, int width, int height)
+{
+    if (mask.empty())
+    {
+        throw invalid_argument("Image is empty");
+    }
+    if (width < 1 || height < 1 || width % 2 == 0 || height % 2 == 0)
+    {
+        throw invalid_argument("Invalid structuring element size");
+    }
+    const Op op;
+    const uint64_t fill = Op::fill;
+    const uint64_t tail = mask.lastWordMask();
+    size_t rowWords = mask.wordsPerRow();
+    size_t rows = mask.height();
+    size_t window = width;
+    size_t half = width / 2;
+
+    // Rows: `line` holds the row starting half a window early, so bit x of
+    // the doubled line covers row pixels x - half ... x + half.
+    size_t paddedRows = rows + height - 1;
+    vector<uint64_t> columns(paddedRows * rowWords, fill);
+    size_t lineWords = (mask.width() + window - 1 + BinaryImage::WORD_BITS - 1) / BinaryImage::WORD_BITS;
+    vector<uint64_t> source(rowWords), line(lineWords), shifted(lineWords);
+    for (uint32_t y = 0; y < rows; y++)
+    {
+        copy(mask.row(y), mask.row(y) + rowWords, source.begin());
+        source[rowWords - 1] = (source[rowWords - 1] & tail) | (fill & ~tail);
+        shiftBits(source.data(), rowWords, -static_cast<ptrdiff_t>(half), fill, line.data(), lineWords);
+        size_t covered = 1;
+        for (; 2 * covered <= window; covered *= 2)
+        {
+            shiftBits(line.data(), lineWords, covered, fill, shifted.data(), lineWords);
+            for (size_t i = 0; i < lineWords; i++)
+            {
+                line[i] = op(line[i], shifted[i]);
+            }
+        }
+        if (covered < window)
+        {
+            shiftBits(line.data(), lineWords, window - covered, fill, shifted.data(), lineWords);
+            for (size_t i = 0; i < lineWords; i++)
+            {
+                line[i] = op(line[i], shifted[i]);
+            }
+        }
+        copy(line.begin(), line.begin() + rowWords, columns.begin() + (y + height / 2) * rowWords);
+    }
+
+    // Columns: the same doubling with whole rows. Padded row j is mask row
+    // j - height / 2; after the loop it covers rows j ... j + covered - 1.
+    size_t covered = 1;
+    for (; 2 * covered <= static_cast<size_t>(height); covered *= 2)
+    {
+        for (size_t j = 0; j + covered < paddedRows; j++)
+        {
+            uint64_t *current = columns.data() + j * rowWords;
+            const uint64_t *below = current + covered * rowWords;
+            for (size_t i = 0; i < rowWords; i++)
+            {
+                current[i] = op(current[i], below[i]);
+            }
+        }
+    }
+    size_t remainder = height - covered;
+    BinaryImage output(mask.width(), mask.height());
+    for (uint32_t y = 0; y < rows; y++)
+    {
+        const uint64_t *head = columns.data() + y * rowWords;
+        const uint64_t *rest = columns.data() + (y + remainder) * rowWords;
+        uint64_t *outRow = output.row(y);
+        for (size_t i = 0; i < rowWords; i++)
+        {
+            outRow[i] = op(head[i], rest[i]);
+        }
+        outRow[rowWords - 1] &= tail;
+    }
+    return output;
+}
+
+BinaryImage BinaryMorphology::erode(const BinaryImage &mask, int width, int height)
+{
+    return shiftMorphology<IntersectionOf>(mask, width, height);
+}
+
+BinaryImage BinaryMorphology::dilate(const BinaryImage &mask, int width, int height)
+{
+    return shiftMorphology<UnionOf>(mask, width, height);
+}
+
+BinaryImage BinaryMorphology::open(const BinaryImage &mask, int width, int height)
+{
+    return dilate(erode(mask, width, height), width, height);
+}
+
+BinaryImage BinaryMorphology::close(const BinaryImage &mask, int width, int height)
+{
+    return erode(dilate(mask, width, height), width, height);
+}
+
+#endif // BINARYMORPHOLOGY_CPP
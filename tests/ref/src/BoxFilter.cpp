@@ -4,11 +4,15 @@
 #include "BoxFilter.hpp"
 #include "FFT.hpp"
 #include "Complex.hpp"
+#include "FFTConvolver.hpp"
+#include "IntegralImage.hpp"
 #include <vector>
 #include <iostream>
 #include <stdexcept>
 #include <cstdint>
 #include <cmath>
+#include <algorithm>
+#include <limits>
 
 template class BoxFilter<uint8_t>;
 template class BoxFilter<uint16_t>;
@@ -16,224 +20,245 @@ template class BoxFilter<uint32_t>;
 template class BoxFilter<uint64_t>;
 
 template <typename T>
-vector<vector<T>> BoxFilter<T>::applyBoxFilterFFT(
-    const vector<vector<T>> &image, int kernelSize)
+Image<T> BoxFilter<T>::applyBoxFilterFFT(
+    const ImageView<const T> &image, int kernelSize)
 {
-    if (image.empty() || image[0].empty())
+    if (image.empty())
     {
         throw invalid_argument("Image is empty");
     }
 
-    int originalRows = image.size();
-    int originalCols = image[0].size();
+    int originalRows = image.height();
+    int originalCols = image.width();
     if (kernelSize > originalRows || kernelSize > originalCols || kernelSize % 2 == 0)
     {
         throw invalid_argument("Invalid kernel size");
     }
-    vector<vector<double>> doubleImage(originalRows, vector<double>(originalCols, 0.0));
-    for (int i = 0; i < originalRows; i++)
+    // The convolver caches the box spectrum, so repeated calls with the same
+    // kernel size only transform the image.
+    vector<vector<double>> kernel(kernelSize, vector<double>(kernelSize, 1.0 / (kernelSize * kernelSize)));
+    return FFTConvolver<T>(kernel).apply(image);
+}
+
+// round(sum / k) for odd k, where the quotient is never exactly halfway,
+// with a hardware divide.
+template <typename Sum>
+struct RoundedDivider
+{
+    Sum k;
+
+    explicit RoundedDivider(Sum k) : k(k) {}
+    Sum operator()(Sum sum) const { return (sum + k / 2) / k; }
+};
+
+// The same as a multiply and shift (Granlund & Montgomery): with
+// l = ceil(log2 k) and m = floor(2^(31 + l) / k) + 1, n * m >> (31 + l)
+// equals n / k for every n < 2^31. The rounded sum must stay below 2^31.
+struct RoundedReciprocalDivider
+{
+    static const uint32_t NUMERATOR_BITS = 31;
+
+    uint32_t half;
+    uint64_t multiplier;
+    uint32_t shift;
+
+    explicit RoundedReciprocalDivider(uint32_t k) : half(k / 2)
     {
-        for (int j = 0; j < originalCols; j++)
+        uint32_t l = 0;
+        while ((uint64_t(1) << l) < k)
         {
-            doubleImage[i][j] = static_cast<double>(image[i][j]);
+            l++;
         }
+        shift = NUMERATOR_BITS + l;
+        multiplier = (uint64_t(1) << shift) / k + 1;
     }
+    uint32_t operator()(uint32_t sum) const
+    {
+        return static_cast<uint32_t>((static_cast<uint64_t>(sum + half) * multiplier) >> shift);
+    }
+};
+
+// Zero-bordered k x k box filter as two 1D passes, each rounding its mean
+// back to T like the direct sums did. Each pass keeps one running sum per
+// sample position: the sample entering the window is added and the one
+// leaving it subtracted, so the cost per pixel does not depend on k.
+template <typename T, typename Sum, typename Divider>
+static Image<T> runningBoxFilter(const ImageView<const T> &inputImg, int kernelSize, uint32_t channels,
+                                 const Divider &mean)
+{
+    size_t rows = inputImg.height();
+    size_t cols = inputImg.width();
+    size_t border = kernelSize / 2;
+    size_t rowLength = cols * channels;
 
-    vector<vector<double>> paddedImage = FFT<T>::zeroPad(doubleImage);
-    int rows = paddedImage.size();
-    int cols = paddedImage[0].size();
-    vector<vector<double>> kernel(rows, vector<double>(cols, 0.0));
-    double normFactor = 1.0 / (kernelSize * kernelSize);
-    int halfKernel = kernelSize / 2;
-    for (int i = 0; i < kernelSize; i++)
+    // Horizontal pass: sums[c] covers samples j - border ... j + border of
+    // channel c; samples outside the row count as zero.
+    Image<T> tempImg(cols, rows, channels);
+    vector<Sum> sums(channels);
+    for (size_t i = 0; i < rows; i++)
     {
-        for (int j = 0; j < kernelSize; j++)
+        const T *inRow = inputImg.row(i);
+        T *tempRow = tempImg.row(i);
+        fill(sums.begin(), sums.end(), Sum(0));
+        for (size_t j = 0; j < border && j < cols; j++)
         {
-            int y = (i - halfKernel + rows) % rows;
-            int x = (j - halfKernel + cols) % cols;
-            kernel[y][x] = normFactor;
+            for (uint32_t c = 0; c < channels; c++)
+            {
+                sums[c] += inRow[j * channels + c];
+            }
         }
-    }
-    vector<vector<Complex>> imageComplex(rows, vector<Complex>(cols));
-    vector<vector<Complex>> kernelComplex(rows, vector<Complex>(cols));
-    for (int i = 0; i < rows; i++)
-    {
-        for (int j = 0; j < cols; j++)
+        for (size_t j = 0; j < cols; j++)
         {
-            imageComplex[i][j] = Complex(paddedImage[i][j], 0.0);
-            kernelComplex[i][j] = Complex(kernel[i][j], 0.0);
+            size_t entering = j + border;
+            for (uint32_t c = 0; c < channels; c++)
+            {
+                if (entering < cols)
+                {
+                    sums[c] += inRow[entering * channels + c];
+                }
+                tempRow[j * channels + c] = static_cast<T>(mean(sums[c]));
+                if (j >= border)
+                {
+                    sums[c] -= inRow[(j - border) * channels + c];
+                }
+            }
         }
     }
-    FFT<T>::fft2D(imageComplex, false);
-    FFT<T>::fft2D(kernelComplex, false);
-    vector<vector<Complex>> resultComplex(rows, vector<Complex>(cols));
-    for (int i = 0; i < rows; i++)
+
+    // Vertical pass: one running sum per sample of a row, updated a whole
+    // row at a time so the inner loops run along contiguous memory.
+    Image<T> outputImg(cols, rows, channels);
+    vector<Sum> columnSums(rowLength, Sum(0));
+    for (size_t i = 0; i < border && i < rows; i++)
     {
-        for (int j = 0; j < cols; j++)
+        const T *tempRow = tempImg.row(i);
+        for (size_t x = 0; x < rowLength; x++)
         {
-            resultComplex[i][j] = imageComplex[i][j] * kernelComplex[i][j];
+            columnSums[x] += tempRow[x];
         }
     }
-    FFT<T>::fft2D(resultComplex, true);
-    vector<vector<double>> paddedResult(rows, vector<double>(cols));
-    for (int i = 0; i < rows; i++)
+    for (size_t i = 0; i < rows; i++)
     {
-        for (int j = 0; j < cols; j++)
+        if (i + border < rows)
+        {
+            const T *enteringRow = tempImg.row(i + border);
+            for (size_t x = 0; x < rowLength; x++)
+            {
+                columnSums[x] += enteringRow[x];
+            }
+        }
+        T *outRow = outputImg.row(i);
+        for (size_t x = 0; x < rowLength; x++)
         {
-            paddedResult[i][j] = resultComplex[i][j].real;
+            outRow[x] = static_cast<T>(mean(columnSums[x]));
+        }
+        if (i >= border)
+        {
+            const T *leavingRow = tempImg.row(i - border);
+            for (size_t x = 0; x < rowLength; x++)
+            {
+                columnSums[x] -= leavingRow[x];
+            }
         }
     }
+    return outputImg;
+}
 
-    // Debugging: Print intermediate results
-    // cout << "Padded Result:" << endl;
-    // for (const auto& row : paddedResult) {
-    //     for (const auto& val : row) {
-    //         cout << val << " ";
-    //     }
-    //     cout << endl;
-    // }
-
-    return FFT<T>::extractOriginalSize(paddedResult, originalRows, originalCols);
+// Picks the accumulator for kernelSize samples of T: 32 bits with a
+// reciprocal divide while the rounded window sum stays below 2^31 (8- and
+// 16-bit images with practical kernels), otherwise 64 bits, or 128 for
+// 64-bit samples, with a hardware divide.
+template <typename T>
+static Image<T> runningBoxFilter(const ImageView<const T> &inputImg, int kernelSize, uint32_t channels)
+{
+    uint64_t k = static_cast<uint64_t>(kernelSize);
+    if (sizeof(T) <= 2 &&
+        k * numeric_limits<T>::max() + k / 2 < (uint64_t(1) << RoundedReciprocalDivider::NUMERATOR_BITS))
+    {
+        return runningBoxFilter<T, uint32_t>(inputImg, kernelSize, channels,
+                                             RoundedReciprocalDivider(static_cast<uint32_t>(k)));
+    }
+#ifdef __SIZEOF_INT128__
+    if (sizeof(T) == 8)
+    {
+        using Sum = unsigned __int128;
+        return runningBoxFilter<T, Sum>(inputImg, kernelSize, channels, RoundedDivider<Sum>(k));
+    }
+#endif
+    return runningBoxFilter<T, uint64_t>(inputImg, kernelSize, channels, RoundedDivider<uint64_t>(k));
 }
 
 template <typename T>
-vector<vector<T>> BoxFilter<T>::applyBoxFilterSlidingGrey(
-    const vector<vector<T>> &inputImg, int kernelSize)
+Image<T> BoxFilter<T>::applyBoxFilterSlidingGrey(
+    const ImageView<const T> &inputImg, int kernelSize)
 {
-    if (inputImg.empty() || inputImg[0].empty())
+    if (inputImg.empty())
     {
         throw invalid_argument("Image is empty");
     }
 
-    vector<vector<T>> outputImg;
-    int rows = inputImg.size();    // Number of rows in the input image
-    int cols = inputImg[0].size(); // Number of columns in the input image
-    int border = kernelSize / 2;   // Border size for padding to handle edges
+    int rows = inputImg.height(); // Number of rows in the input image
+    int cols = inputImg.width();  // Number of columns in the input image
     // Check if kernel size is greater than image dimensions
-    if (kernelSize > rows || kernelSize > cols || kernelSize % 2 == 0)
+    if (kernelSize < 1 || kernelSize > rows || kernelSize > cols || kernelSize % 2 == 0)
     {
         throw invalid_argument("Invalid kernel size");
     }
 
-    // Initialize the output image with the same size as the input
-    outputImg.resize(rows, vector<T>(cols, 0));
-
-    // Create a padded version of the input image to handle borders
-    vector<vector<T>> padded(rows + 2 * border, vector<T>(cols + 2 * border, 0));
+    return runningBoxFilter(inputImg, kernelSize, 1);
+}
 
-    // Copy the input image into the center of the padded image
-    for (int i = 0; i < rows; i++)
+template <typename T>
+Image<T> BoxFilter<T>::applyBoxFilterSlidingRGB(
+    const ImageView<const T> &inputImg, int kernelSize)
+{
+    if (inputImg.empty())
     {
-        for (int j = 0; j < cols; j++)
-        {
-            padded[i + border][j + border] = inputImg[i][j];
-        }
+        throw invalid_argument("Image is empty");
     }
 
-    // Apply the horizontal box filter
-    vector<vector<T>> tempImg = padded;
-    for (int i = 0; i < rows; i++)
+    int rows = inputImg.height();       // Number of rows in the input image
+    int cols = inputImg.width();        // Number of columns in the input image
+    if (kernelSize < 1 || kernelSize > rows || kernelSize > cols || kernelSize % 2 == 0)
     {
-        for (int j = 0; j < cols; j++)
-        {
-            double sum = 0.0;
-            for (int kj = -border; kj <= border; kj++)
-            {
-                sum += padded[i + border][j + border + kj];
-            }
-            tempImg[i + border][j + border] = static_cast<T>(round(sum / kernelSize));
-        }
-    }
-    // Apply the vertical box filter
-    for (int i = 0; i < rows; i++)
-    {
-        for (int j = 0; j < cols; j++)
-        {
-            double sum = 0.0;
-            for (int ki = -border; ki <= border; ki++)
-            {
-                sum += tempImg[i + border + ki][j + border];
-            }
-            outputImg[i][j] = static_cast<T>(round(sum / kernelSize));
-        }
+        throw invalid_argument("Invalid kernel size");
     }
 
-    return outputImg;
+    return runningBoxFilter(inputImg, kernelSize, inputImg.channels());
 }
 
 template <typename T>
-vector<vector<vector<T>>> BoxFilter<T>::applyBoxFilterSlidingRGB(
-    const vector<vector<vector<T>>> &inputImg, int kernelSize)
+Image<T> BoxFilter<T>::applyBoxFilterIntegral(
+    const ImageView<const T> &image, int kernelSize)
 {
-    if (inputImg.empty() || inputImg[0].empty())
+    if (image.empty())
     {
         throw invalid_argument("Image is empty");
     }
 
-    vector<vector<vector<T>>> outputImg;
-    int rows = inputImg.size();           // Number of rows in the input image
-    int cols = inputImg[0].size();        // Number of columns in the input image
-    int channels = inputImg[0][0].size(); // Number of color channels
-    if (kernelSize > rows || kernelSize > cols || kernelSize % 2 == 0)
+    int rows = image.height();
+    int cols = image.width();
+    if (kernelSize < 1 || kernelSize > rows || kernelSize > cols || kernelSize % 2 == 0)
     {
         throw invalid_argument("Invalid kernel size");
     }
-    int border = kernelSize / 2; // Border size for padding to handle edges
-
-    // Initialize the output image with the same size as the input
-    outputImg.resize(rows, vector<vector<T>>(cols, vector<T>(channels, 0)));
-
-    // Create a padded version of the input image to handle borders
-    vector<vector<vector<T>>> padded(rows + 2 * border, vector<vector<T>>(cols + 2 * border, vector<T>(channels, 0)));
-
-    // Copy the input image into the center of the padded image
-    for (int i = 0; i < rows; i++)
-    {
-        for (int j = 0; j < cols; j++)
-        {
-            for (int c = 0; c < channels; c++)
-            {
-                padded[i + border][j + border][c] = inputImg[i][j][c];
-            }
-        }
-    }
+    return IntegralImage<T>(image).boxFilter(kernelSize);
+}
 
-    // Apply the horizontal box filter
-    vector<vector<vector<T>>> tempImg = padded;
-    for (int i = 0; i < rows; i++)
+template <typename T>
+Image<T> BoxFilter<T>::applyBoxFilterDirect(
+    const ImageView<const T> &image, int kernelSize, BorderMode border)
+{
+    if (image.empty())
     {
-        for (int j = 0; j < cols; j++)
-        {
-            for (int c = 0; c < channels; c++)
-            {
-                double sum = 0.0;
-                for (int kj = -border; kj <= border; kj++)
-                {
-                    sum += padded[i + border][j + border + kj][c];
-                }
-                tempImg[i + border][j + border][c] = static_cast<T>(round(sum / kernelSize));
-            }
-        }
+        throw invalid_argument("Image is empty");
     }
-
-    // Apply the vertical box filter
-    for (int i = 0; i < rows; i++)
+    if (kernelSize < 1 || kernelSize % 2 == 0)
     {
-        for (int j = 0; j < cols; j++)
-        {
-            for (int c = 0; c < channels; c++)
-            {
-                double sum = 0.0;
-                for (int ki = -border; ki <= border; ki++)
-                {
-                    sum += tempImg[i + border + ki][j + border][c];
-                }
-                outputImg[i][j][c] = static_cast<T>(round(sum / kernelSize));
-            }
-        }
+        throw invalid_argument("Invalid kernel size");
     }
-
-    return outputImg;
+    vector<double> taps(kernelSize, 1.0 / kernelSize);
+    return Convolution<T>::convolveSeparable(image, taps, taps, border, OutputRounding::NEAREST);
 }
 
 #endif // BOXFILTER_CPP
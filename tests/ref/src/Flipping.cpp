@@ -3,6 +3,7 @@
 
 #include "Flipping.hpp"
 #include <vector>
+#include <algorithm>
 
 template class ImageFlipper<uint8_t>;
 template class ImageFlipper<uint16_t>;
@@ -13,52 +14,76 @@ template <typename T>
 void ImageFlipper<T>::flip(Image<T> &image, FlippingDirection direction)
 {
 
-    if (image.pixelMatrix.empty())
+    if (image.empty())
     {
-        throw FlipError("Pixel matrix is empty, cannot Flip image.");
+        throw FlipError("Pixel buffer is empty, cannot Flip image.");
     }
     switch (direction)
     {
     case FlippingDirection::VERTICAL:
-        flipVertical(image.pixelMatrix);
+        image.reorient(Orientation::mirroredVertically());
         break;
     case FlippingDirection::HORIZONTAL:
-        flipHorizontal(image.pixelMatrix);
+        image.reorient(Orientation::mirroredHorizontally());
         break;
     default:
         throw FlipError("Unsupported Flip direction.");
     }
+}
 
-    image.metadata.width = image.pixelMatrix[0].size();
-    image.metadata.height = image.pixelMatrix.size();
+template <typename T>
+void ImageFlipper<T>::flip(const ImageView<T> &view, FlippingDirection direction)
+{
+    if (view.empty())
+    {
+        throw FlipError("Pixel buffer is empty, cannot Flip image.");
+    }
+    switch (direction)
+    {
+    case FlippingDirection::VERTICAL:
+        flipVertical(view);
+        break;
+    case FlippingDirection::HORIZONTAL:
+        flipHorizontal(view);
+        break;
+    default:
+        throw FlipError("Unsupported Flip direction.");
+    }
 }
 
 template <typename T>
-void ImageFlipper<T>::flipVertical(vector<vector<T>> &matrix)
+void ImageFlipper<T>::flipVertical(const ImageView<T> &view)
 {
-    size_t height = matrix.size();
-    size_t width = matrix[0].size();
+    size_t height = view.height();
+    size_t rowLength = view.rowLength();
 
     for (size_t i = 0; i < height / 2; ++i)
     {
-        for (size_t j = 0; j < width; ++j)
-        {
-            swap(matrix[i][j], matrix[height - 1 - i][j]);
-        }
+        swap_ranges(view.row(i), view.row(i) + rowLength, view.row(height - 1 - i));
     }
 }
 
 template <typename T>
-void ImageFlipper<T>::flipHorizontal(vector<vector<T>> &matrix)
+void ImageFlipper<T>::flipHorizontal(const ImageView<T> &view)
 {
-    size_t height = matrix.size();
-    size_t width = matrix[0].size();
+    size_t height = view.height();
+    size_t width = view.width();
+    size_t channels = view.channels();
 
+    if (channels == 1)
+    {
+        for (size_t i = 0; i < height; ++i)
+        {
+            reverseSamples(view.row(i), width);
+        }
+        return;
+    }
     for (size_t i = 0; i < height; ++i)
     {
+        T *row = view.row(i);
         for (size_t j = 0; j < width / 2; ++j)
         {
-            swap(matrix[i][j], matrix[i][width - 1 - j]);
+            swap_ranges(row + j * channels, row + (j + 1) * channels, row + (width - 1 - j) * channels);
         }
     }
 }
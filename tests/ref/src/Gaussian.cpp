@@ -5,68 +5,79 @@
 #include <vector>
 #include <cmath>
 #include <cstdint>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <map>
+#include <mutex>
+#include <tuple>
 
 // Explicit template instantiation
-template vector<vector<uint8_t>> applyGaussianFilter<uint8_t>(const vector<vector<uint8_t>> &, const vector<vector<double>> &);
-template vector<vector<uint16_t>> applyGaussianFilter<uint16_t>(const vector<vector<uint16_t>> &, const vector<vector<double>> &);
-template vector<vector<uint32_t>> applyGaussianFilter<uint32_t>(const vector<vector<uint32_t>> &, const vector<vector<double>> &);
-template vector<vector<uint64_t>> applyGaussianFilter<uint64_t>(const vector<vector<uint64_t>> &, const vector<vector<double>> &);
+template Image<uint8_t> applyGaussianFilter<uint8_t>(const ImageView<const uint8_t> &, const vector<vector<double>> &, BorderMode);
+template Image<uint16_t> applyGaussianFilter<uint16_t>(const ImageView<const uint16_t> &, const vector<vector<double>> &, BorderMode);
+template Image<uint32_t> applyGaussianFilter<uint32_t>(const ImageView<const uint32_t> &, const vector<vector<double>> &, BorderMode);
+template Image<uint64_t> applyGaussianFilter<uint64_t>(const ImageView<const uint64_t> &, const vector<vector<double>> &, BorderMode);
+
+template Image<uint8_t> zeroPad<uint8_t>(const ImageView<const uint8_t> &, int);
+template Image<uint16_t> zeroPad<uint16_t>(const ImageView<const uint16_t> &, int);
+template Image<uint32_t> zeroPad<uint32_t>(const ImageView<const uint32_t> &, int);
+template Image<uint64_t> zeroPad<uint64_t>(const ImageView<const uint64_t> &, int);
+
+template Image<uint8_t> applyGaussianFilterSeparable<uint8_t>(const ImageView<const uint8_t> &, int, double, BorderMode);
+template Image<uint16_t> applyGaussianFilterSeparable<uint16_t>(const ImageView<const uint16_t> &, int, double, BorderMode);
+template Image<uint32_t> applyGaussianFilterSeparable<uint32_t>(const ImageView<const uint32_t> &, int, double, BorderMode);
+template Image<uint64_t> applyGaussianFilterSeparable<uint64_t>(const ImageView<const uint64_t> &, int, double, BorderMode);
+
+template Image<uint8_t> applyGaussianFilterFixedPoint<uint8_t>(const ImageView<const uint8_t> &, int, double);
+template Image<uint16_t> applyGaussianFilterFixedPoint<uint16_t>(const ImageView<const uint16_t> &, int, double);
+
+template Image<uint8_t> applyGaussianFilterRecursive<uint8_t>(const ImageView<const uint8_t> &, double);
+template Image<uint16_t> applyGaussianFilterRecursive<uint16_t>(const ImageView<const uint16_t> &, double);
+template Image<uint32_t> applyGaussianFilterRecursive<uint32_t>(const ImageView<const uint32_t> &, double);
+template Image<uint64_t> applyGaussianFilterRecursive<uint64_t>(const ImageView<const uint64_t> &, double);
 
 //--------------------------------------------------
-// 2D Gaussian Kernel (integrated version)
+// Gaussian kernels (closed form, cached)
 //--------------------------------------------------
-vector<vector<double>> generateGaussianKernel(int kernelSize, double sigma)
-{
-    vector<vector<double>> kernel(kernelSize, vector<double>(kernelSize, 0));
-    double sum = 0.0;
-    int half = kernelSize / 2;
-    double twoSigmaSquare = 2 * sigma * sigma;
-    double constant = 1.0 / (2 * M_PI * sigma * sigma);
-    double step = 0.001; // integration increment
 
-    // Loop over each pixel in the kernel
-    for (int i = -half; i <= half; i++)
+// Kernels kept across calls; past this the cache is emptied and refilled.
+// Kernels already handed out stay valid.
+static const size_t GAUSSIAN_KERNEL_CACHE_CAPACITY = 256;
+
+using GaussianKernelKey = tuple<int, double, GaussianKernelMode>;
+
+static void checkKernelArguments(int kernelSize, double sigma)
+{
+    if (kernelSize < 1 || kernelSize % 2 == 0)
     {
-        for (int j = -half; j <= half; j++)
-        {
-            double integratedValue = 0.0;
-            // Integrate over the pixel area from (i - 0.5) to (i + 0.5) and (j - 0.5) to (j + 0.5)
-            for (double x = i - 0.5; x < i + 0.5; x += step)
-            {
-                for (double y = j - 0.5; y < j + 0.5; y += step)
-                {
-                    integratedValue += constant * exp(-(x * x + y * y) / twoSigmaSquare) * step * step;
-                }
-            }
-            kernel[i + half][j + half] = integratedValue;
-            sum += integratedValue;
-        }
+        throw invalid_argument("Invalid kernel size");
     }
-    // Normalize the kernel so that the sum of all elements is 1
-    for (int i = 0; i < kernelSize; i++)
+    if (!(sigma > 0))
     {
-        for (int j = 0; j < kernelSize; j++)
-        {
-            kernel[i][j] /= sum;
-        }
+        throw invalid_argument("Sigma must be positive");
     }
-    return kernel;
 }
 
-//--------------------------------------------------
-// 1D Gaussian Kernel (for separable convolution)
-//--------------------------------------------------
-vector<double> generateGaussianKernel1D(int kernelSize, double sigma)
+static vector<double> computeGaussianKernel1D(int kernelSize, double sigma, GaussianKernelMode mode)
 {
     int half = kernelSize / 2;
     vector<double> kernel(kernelSize, 0.0);
     double sum = 0.0;
     double twoSigmaSquare = 2 * sigma * sigma;
     double constant = 1.0 / (sqrt(2 * M_PI) * sigma);
-
+    double erfScale = 1.0 / (sqrt(2.0) * sigma);
     for (int i = -half; i <= half; i++)
     {
-        double value = constant * exp(-(i * i) / twoSigmaSquare);
+        double value;
+        if (mode == GaussianKernelMode::INTEGRATED)
+        {
+            // Mass of the Gaussian over the pixel [i - 0.5, i + 0.5].
+            value = 0.5 * (erf((i + 0.5) * erfScale) - erf((i - 0.5) * erfScale));
+        }
+        else
+        {
+            value = constant * exp(-(i * i) / twoSigmaSquare);
+        }
         kernel[i + half] = value;
         sum += value;
     }
@@ -78,25 +89,89 @@ vector<double> generateGaussianKernel1D(int kernelSize, double sigma)
     return kernel;
 }
 
-//--------------------------------------------------
-// Zero padding for T images with a given pad size
-//--------------------------------------------------
-template <typename T>
-vector<vector<T>> zeroPad(const vector<vector<T>> &image, int pad)
+shared_ptr<const vector<double>> cachedGaussianKernel1D(int kernelSize, double sigma, GaussianKernelMode mode)
+{
+    checkKernelArguments(kernelSize, sigma);
+    static mutex cacheMutex;
+    static map<GaussianKernelKey, shared_ptr<const vector<double>>> cache;
+
+    GaussianKernelKey key(kernelSize, sigma, mode);
+    lock_guard<mutex> lock(cacheMutex);
+    auto it = cache.find(key);
+    if (it != cache.end())
+    {
+        return it->second;
+    }
+    if (cache.size() >= GAUSSIAN_KERNEL_CACHE_CAPACITY)
+    {
+        cache.clear();
+    }
+    shared_ptr<const vector<double>> kernel =
+        make_shared<const vector<double>>(computeGaussianKernel1D(kernelSize, sigma, mode));
+    return cache.emplace(key, kernel).first->second;
+}
+
+shared_ptr<const vector<vector<double>>> cachedGaussianKernel2D(int kernelSize, double sigma, GaussianKernelMode mode)
 {
-    int rows = image.size();
-    int cols = image[0].size();
-    int paddedRows = rows + 2 * pad;
-    int paddedCols = cols + 2 * pad;
+    checkKernelArguments(kernelSize, sigma);
+    static mutex cacheMutex;
+    static map<GaussianKernelKey, shared_ptr<const vector<vector<double>>>> cache;
 
-    vector<vector<T>> padded(paddedRows, vector<T>(paddedCols, 0));
-    for (int i = 0; i < rows; i++)
+    GaussianKernelKey key(kernelSize, sigma, mode);
+    {
+        lock_guard<mutex> lock(cacheMutex);
+        auto it = cache.find(key);
+        if (it != cache.end())
+        {
+            return it->second;
+        }
+    }
+    // The Gaussian is separable, so each pixel's mass (or density) is the
+    // product of the 1D values; the 1D kernel sums to one and so does this.
+    shared_ptr<const vector<double>> kernel1D = cachedGaussianKernel1D(kernelSize, sigma, mode);
+    auto kernel = make_shared<vector<vector<double>>>(kernelSize, vector<double>(kernelSize));
+    for (int i = 0; i < kernelSize; i++)
     {
-        for (int j = 0; j < cols; j++)
+        for (int j = 0; j < kernelSize; j++)
         {
-            padded[i + pad][j + pad] = image[i][j];
+            (*kernel)[i][j] = (*kernel1D)[i] * (*kernel1D)[j];
         }
     }
+    lock_guard<mutex> lock(cacheMutex);
+    if (cache.size() >= GAUSSIAN_KERNEL_CACHE_CAPACITY)
+    {
+        cache.clear();
+    }
+    return cache.emplace(key, move(kernel)).first->second;
+}
+
+//--------------------------------------------------
+// 2D Gaussian Kernel (integrated version)
+//--------------------------------------------------
+vector<vector<double>> generateGaussianKernel(int kernelSize, double sigma, GaussianKernelMode mode)
+{
+    return *cachedGaussianKernel2D(kernelSize, sigma, mode);
+}
+
+//--------------------------------------------------
+// 1D Gaussian Kernel (for separable convolution)
+//--------------------------------------------------
+vector<double> generateGaussianKernel1D(int kernelSize, double sigma, GaussianKernelMode mode)
+{
+    return *cachedGaussianKernel1D(kernelSize, sigma, mode);
+}
+
+//--------------------------------------------------
+// Zero padding for T images with a given pad size
+//--------------------------------------------------
+template <typename T>
+Image<T> zeroPad(const ImageView<const T> &image, int pad)
+{
+    int rows = image.height();
+    int cols = image.width();
+
+    Image<T> padded(cols + 2 * pad, rows + 2 * pad);
+    copyPixels(image, padded.view().subView(pad, pad, cols, rows));
     return padded;
 }
 
@@ -104,93 +179,292 @@ vector<vector<T>> zeroPad(const vector<vector<T>> &image, int pad)
 // 2D convolution version
 //--------------------------------------------------
 template <typename T>
-vector<vector<T>> applyGaussianFilter(
-    const vector<vector<T>> &image,
-    const vector<vector<double>> &kernel)
+Image<T> applyGaussianFilter(
+    const ImageView<const T> &image,
+    const vector<vector<double>> &kernel,
+    BorderMode border)
+{
+    // Gaussian kernels are rank one, so this normally runs as a single
+    // separable pass; other kernels get as many as they need.
+    return Convolution<T>::convolve(image, kernel, border, OutputRounding::TRUNCATE);
+}
+
+//--------------------------------------------------
+// Separable convolution version (optimized) using the fact that Gaussian kernel is separable
+//--------------------------------------------------
+template <typename T>
+Image<T> applyGaussianFilterSeparable(
+    const ImageView<const T> &image,
+    int kernelSize,
+    double sigma,
+    BorderMode border)
+{
+    // The shared 1D Gaussian kernel, along rows and then along columns
+    shared_ptr<const vector<double>> kernel1D =
+        cachedGaussianKernel1D(kernelSize, sigma, GaussianKernelMode::SAMPLED);
+    return Convolution<T>::convolveSeparable(image, *kernel1D, *kernel1D, border, OutputRounding::TRUNCATE);
+}
+
+//--------------------------------------------------
+// Fixed-point separable version for 8- and 16-bit images
+//--------------------------------------------------
+
+// Weights of the 1D kernel in units of 2^-fractionBits, summing to exactly
+// 2^fractionBits: each is rounded and the rounding residue goes to the
+// centre tap.
+static vector<uint32_t> quantizeKernel(const vector<double> &kernel, int fractionBits)
+{
+    double one = static_cast<double>(uint32_t(1) << fractionBits);
+    vector<uint32_t> weights(kernel.size());
+    int64_t total = 0;
+    for (size_t k = 0; k < kernel.size(); k++)
+    {
+        weights[k] = static_cast<uint32_t>(llround(kernel[k] * one));
+        total += weights[k];
+    }
+    weights[kernel.size() / 2] += static_cast<int64_t>(one) - total;
+    return weights;
+}
+
+template <typename T>
+Image<T> applyGaussianFilterFixedPoint(
+    const ImageView<const T> &image,
+    int kernelSize,
+    double sigma)
 {
+    static_assert(sizeof(T) <= 2, "Fixed-point Gaussian is for 8- and 16-bit images");
+    if (image.empty())
+    {
+        throw invalid_argument("Image is empty");
+    }
+    if (kernelSize < 1 || kernelSize % 2 == 0)
+    {
+        throw invalid_argument("Invalid kernel size");
+    }
 
-    int height = image.size();
-    int width = image[0].size();
-    int kSize = kernel.size();
-    int half = kSize / 2;
+    // Q15 weights for 8-bit input keep a horizontal sum below 2^23, which
+    // leaves 8 fractional bits in a 16-bit intermediate and keeps the
+    // vertical sum below 2^31. 16-bit input takes Q16 weights and an integer
+    // intermediate; both sums then stay below 2^32.
+    const int weightBits = sizeof(T) == 1 ? 15 : 16;
+    const int intermediateBits = sizeof(T) == 1 ? 8 : 0;
+    const int horizontalShift = weightBits - intermediateBits;
+    const int verticalShift = weightBits + intermediateBits;
+    const uint32_t horizontalHalf = uint32_t(1) << (horizontalShift - 1);
+    const uint32_t verticalHalf = uint32_t(1) << (verticalShift - 1);
 
-    // Pad the image with 'half' pixels on each side
-    vector<vector<T>> paddedImage = zeroPad(image, half);
+    size_t height = image.height();
+    size_t width = image.width();
+    size_t half = kernelSize / 2;
+    vector<uint32_t> weights =
+        quantizeKernel(*cachedGaussianKernel1D(kernelSize, sigma, GaussianKernelMode::SAMPLED), weightBits);
 
-    // Create an output image with the same dimensions as the original image
-    vector<vector<T>> output(height, vector<T>(width, 0));
+    // Horizontal pass: each row is widened into a zero-bordered line, then
+    // accumulated tap by tap across the whole row so the inner loop is a
+    // plain multiply-add over contiguous integers.
+    Image<uint16_t> intermediate(width, height);
+    vector<uint32_t> line(width + 2 * half, 0);
+    vector<uint32_t> sums(width);
+    for (size_t i = 0; i < height; i++)
+    {
+        const T *inRow = image.row(i);
+        copy(inRow, inRow + width, line.begin() + half);
+        fill(sums.begin(), sums.end(), horizontalHalf);
+        for (size_t k = 0; k < weights.size(); k++)
+        {
+            const uint32_t weight = weights[k];
+            const uint32_t *source = line.data() + k;
+            for (size_t j = 0; j < width; j++)
+            {
+                sums[j] += weight * source[j];
+            }
+        }
+        uint16_t *outRow = intermediate.row(i);
+        for (size_t j = 0; j < width; j++)
+        {
+            outRow[j] = static_cast<uint16_t>(sums[j] >> horizontalShift);
+        }
+    }
 
-    // Perform convolution on the padded image
-    for (int i = 0; i < height; i++)
+    // Vertical pass: rows outside the image are zero and are skipped.
+    Image<T> output(width, height);
+    for (size_t i = 0; i < height; i++)
     {
-        for (int j = 0; j < width; j++)
+        fill(sums.begin(), sums.end(), verticalHalf);
+        size_t firstTap = i < half ? half - i : 0;
+        size_t lastTap = min(weights.size(), height + half - i);
+        for (size_t k = firstTap; k < lastTap; k++)
         {
-            double sum = 0.0;
-            for (int m = 0; m < kSize; m++)
+            const uint32_t weight = weights[k];
+            const uint16_t *source = intermediate.row(i + k - half);
+            for (size_t j = 0; j < width; j++)
             {
-                for (int n = 0; n < kSize; n++)
-                {
-                    sum += paddedImage[i + m][j + n] * kernel[m][n];
-                }
+                sums[j] += weight * source[j];
             }
-            output[i][j] = static_cast<T>(sum);
+        }
+        T *outRow = output.row(i);
+        for (size_t j = 0; j < width; j++)
+        {
+            outRow[j] = static_cast<T>(sums[j] >> verticalShift);
         }
     }
     return output;
 }
 
 //--------------------------------------------------
-// Separable convolution version (optimized) using the fact that Gaussian kernel is separable
+// Recursive (IIR) version: Young & van Vliet, with the Triggs & Sdika
+// boundary correction
 //--------------------------------------------------
+
+// Causal pass    w[n] = B x[n] + a1 w[n-1] + a2 w[n-2] + a3 w[n-3],
+// anti-causal    y[n] = B w[n] + a1 y[n+1] + a2 y[n+2] + a3 y[n+3].
+struct RecursiveGaussianCoefficients
+{
+    double B;
+    double a1, a2, a3;
+    // Maps the last causal outputs (w[N-1], w[N-2], w[N-3]) to the values
+    // (y[N], y[N+1], y[N+2]) the anti-causal pass starts from, for a signal
+    // that is zero past its end.
+    double M[3][3];
+};
+
+static RecursiveGaussianCoefficients recursiveGaussianCoefficients(double sigma)
+{
+    // Young, van Vliet & van Ginkel (2002).
+    double q = sigma >= 2.5 ? 0.98711 * sigma - 0.96330 : 3.97156 - 4.14554 * sqrt(1.0 - 0.26891 * sigma);
+    double b0 = 1.57825 + 2.44413 * q + 1.4281 * q * q + 0.422205 * q * q * q;
+    double b1 = 2.44413 * q + 2.85619 * q * q + 1.26661 * q * q * q;
+    double b2 = -(1.4281 * q * q + 1.26661 * q * q * q);
+    double b3 = 0.422205 * q * q * q;
+
+    RecursiveGaussianCoefficients c;
+    c.a1 = b1 / b0;
+    c.a2 = b2 / b0;
+    c.a3 = b3 / b0;
+    c.B = 1.0 - (c.a1 + c.a2 + c.a3);
+
+    // Column k of M is the response to a unit causal state e_k: run the
+    // causal recursion on past the end with zero input until it has died
+    // out, then the anti-causal one back from there. This evaluates the
+    // Triggs & Sdika matrix numerically.
+    for (int k = 0; k < 3; k++)
+    {
+        vector<double> w = {k == 2 ? 1.0 : 0.0, k == 1 ? 1.0 : 0.0, k == 0 ? 1.0 : 0.0};
+        while (w.size() < 100000000)
+        {
+            size_t n = w.size();
+            double next = c.a1 * w[n - 1] + c.a2 * w[n - 2] + c.a3 * w[n - 3];
+            w.push_back(next);
+            if (n > 3 && fabs(next) < 1e-20 && fabs(w[n - 1]) < 1e-20 && fabs(w[n - 2]) < 1e-20)
+                break;
+        }
+        // w[3] is w[N]; y[n] for n >= N.
+        size_t tail = w.size();
+        vector<double> y(tail + 3, 0.0);
+        for (size_t n = tail; n-- > 3;)
+        {
+            y[n] = c.B * w[n] + c.a1 * y[n + 1] + c.a2 * y[n + 2] + c.a3 * y[n + 3];
+        }
+        for (int r = 0; r < 3; r++)
+        {
+            c.M[r][k] = y[3 + r];
+        }
+    }
+    return c;
+}
+
 template <typename T>
-vector<vector<T>> applyGaussianFilterSeparable(
-    const vector<vector<T>> &image,
-    int kernelSize,
+Image<T> applyGaussianFilterRecursive(
+    const ImageView<const T> &image,
     double sigma)
 {
+    if (image.empty())
+    {
+        throw invalid_argument("Image is empty");
+    }
+    if (!(sigma >= 0.5))
+    {
+        throw invalid_argument("Recursive Gaussian needs sigma >= 0.5");
+    }
 
-    int height = image.size();
-    int width = image[0].size();
-    int half = kernelSize / 2;
-
-    // Generate the 1D Gaussian kernel
-    vector<double> kernel1D = generateGaussianKernel1D(kernelSize, sigma);
+    size_t height = image.height();
+    size_t width = image.width();
+    RecursiveGaussianCoefficients c = recursiveGaussianCoefficients(sigma);
 
-    // First pass: horizontal convolution.
-    vector<vector<double>> intermediate(height, vector<double>(width, 0.0));
-    for (int i = 0; i < height; i++)
+    // Horizontal pass, one row at a time in a line buffer with three zeros
+    // of history before the row and the anti-causal start values after it.
+    Image<double> intermediate(width, height);
+    vector<double> line(width + 6, 0.0);
+    double *w = line.data() + 3;
+    for (size_t i = 0; i < height; i++)
     {
-        for (int j = 0; j < width; j++)
+        const T *inRow = image.row(i);
+        for (size_t j = 0; j < width; j++)
         {
-            double sum = 0.0;
-            for (int k = -half; k <= half; k++)
-            {
-                int col = j + k;
-                // Zero padding: if the index is out-of-bounds, assume 0.
-                if (col < 0 || col >= width)
-                    continue;
-                sum += image[i][col] * kernel1D[k + half];
-            }
-            intermediate[i][j] = sum;
+            w[j] = c.B * inRow[j] + c.a1 * w[j - 1] + c.a2 * w[j - 2] + c.a3 * w[j - 3];
+        }
+        double last[3] = {w[width - 1], w[width - 2], w[width - 3]};
+        for (int r = 0; r < 3; r++)
+        {
+            w[width + r] = c.M[r][0] * last[0] + c.M[r][1] * last[1] + c.M[r][2] * last[2];
+        }
+        double *outRow = intermediate.row(i);
+        for (size_t j = width; j-- > 0;)
+        {
+            w[j] = c.B * w[j] + c.a1 * w[j + 1] + c.a2 * w[j + 2] + c.a3 * w[j + 3];
+            outRow[j] = w[j];
         }
     }
 
-    // Second pass: vertical convolution.
-    vector<vector<T>> output(height, vector<T>(width, 0));
-    for (int i = 0; i < height; i++)
+    // Vertical pass in place, a whole row at a time so the inner loops run
+    // along contiguous memory. Rows outside the image read as zero.
+    vector<double> zeros(width, 0.0);
+    auto rowOrZero = [&](size_t i) -> const double * {
+        return i < height ? intermediate.row(i) : zeros.data();
+    };
+    for (size_t i = 0; i < height; i++)
+    {
+        double *current = intermediate.row(i);
+        const double *p1 = rowOrZero(i - 1);
+        const double *p2 = rowOrZero(i - 2);
+        const double *p3 = rowOrZero(i - 3);
+        for (size_t j = 0; j < width; j++)
+        {
+            current[j] = c.B * current[j] + c.a1 * p1[j] + c.a2 * p2[j] + c.a3 * p3[j];
+        }
+    }
+    vector<vector<double>> after(3, vector<double>(width));
     {
-        for (int j = 0; j < width; j++)
+        const double *l0 = rowOrZero(height - 1);
+        const double *l1 = rowOrZero(height - 2);
+        const double *l2 = rowOrZero(height - 3);
+        for (int r = 0; r < 3; r++)
         {
-            double sum = 0.0;
-            for (int k = -half; k <= half; k++)
+            for (size_t j = 0; j < width; j++)
             {
-                int row = i + k;
-                // Zero padding: if the index is out-of-bounds, assume 0.
-                if (row < 0 || row >= height)
-                    continue;
-                sum += intermediate[row][j] * kernel1D[k + half];
+                after[r][j] = c.M[r][0] * l0[j] + c.M[r][1] * l1[j] + c.M[r][2] * l2[j];
             }
-            output[i][j] = static_cast<T>(sum);
+        }
+    }
+    auto below = [&](size_t i) -> const double * {
+        return i < height ? intermediate.row(i) : after[i - height].data();
+    };
+    Image<T> output(width, height);
+    const double largest = static_cast<double>(numeric_limits<T>::max());
+    for (size_t i = height; i-- > 0;)
+    {
+        double *current = intermediate.row(i);
+        const double *n1 = below(i + 1);
+        const double *n2 = below(i + 2);
+        const double *n3 = below(i + 3);
+        T *outRow = output.row(i);
+        for (size_t j = 0; j < width; j++)
+        {
+            double value = c.B * current[j] + c.a1 * n1[j] + c.a2 * n2[j] + c.a3 * n3[j];
+            current[j] = value;
+            // Truncated like the other versions; the recursion can ring
+            // slightly outside the input range.
+            outRow[j] = value <= 0.0 ? T(0) : value >= largest ? numeric_limits<T>::max() : static_cast<T>(value);
         }
     }
     return output;
@@ -0,0 +1,334 @@
+#ifndef MEDIANFILTER_CPP
+#define MEDIANFILTER_CPP
+
+#include "MedianFilter.hpp"
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+template class MedianFilter<uint8_t>;
+template class MedianFilter<uint16_t>;
+
+// Most bytes of fine column histograms one stripe may hold. 8-bit images
+// always fit in a single stripe; 16-bit ones need 128 KiB per column.
+static const size_t MEDIAN_HISTOGRAM_BUDGET = size_t(1) << 24;
+// Narrowest stripe of output columns, however large the kernel.
+static const size_t MIN_STRIPE_WIDTH = 32;
+// Pixels per strip the sorting networks run across.
+static const size_t NETWORK_STRIP = 256;
+
+// One compare-exchange: afterwards `low` holds the smaller value.
+struct CompareExchange
+{
+    uint8_t low;
+    uint8_t high;
+};
+
+static const CompareExchange MEDIAN9_NETWORK[] = {
+    {1, 2}, {4, 5}, {7, 8}, {0, 1}, {3, 4}, {6, 7}, {1, 2}, {4, 5}, {7, 8}, {0, 3},
+    {5, 8}, {4, 7}, {3, 6}, {1, 4}, {2, 5}, {4, 7}, {4, 2}, {6, 4}, {4, 2}};
+
+static const CompareExchange MEDIAN25_NETWORK[] = {
+    {0, 1},   {3, 4},   {2, 4},   {2, 3},   {6, 7},   {5, 7},   {5, 6},   {9, 10},  {8, 10},  {8, 9},
+    {12, 13}, {11, 13}, {11, 12}, {15, 16}, {14, 16}, {14, 15}, {18, 19}, {17, 19}, {17, 18}, {21, 22},
+    {20, 22}, {20, 21}, {23, 24}, {2, 5},   {3, 6},   {0, 6},   {0, 3},   {4, 7},   {1, 7},   {1, 4},
+    {11, 14}, {8, 14},  {8, 11},  {12, 15}, {9, 15},  {9, 12},  {13, 16}, {10, 16}, {10, 13}, {20, 23},
+    {17, 23}, {17, 20}, {21, 24}, {18, 24}, {18, 21}, {19, 22}, {8, 17},  {9, 18},  {0, 18},  {0, 9},
+    {10, 19}, {1, 19},  {1, 10},  {11, 20}, {2, 20},  {2, 11},  {12, 21}, {3, 21},  {3, 12},  {13, 22},
+    {4, 22},  {4, 13},  {14, 23}, {5, 23},  {5, 14},  {15, 24}, {6, 24},  {6, 15},  {7, 16},  {7, 19},
+    {13, 21}, {15, 23}, {7, 13},  {7, 15},  {1, 9},   {3, 11},  {5, 17},  {11, 17}, {9, 17},  {4, 10},
+    {6, 12},  {7, 14},  {4, 6},   {4, 7},   {12, 14}, {10, 14}, {6, 7},   {10, 12}, {6, 10},  {6, 17},
+    {12, 17}, {7, 17},  {7, 10},  {12, 18}, {7, 12},  {10, 18}, {12, 20}, {10, 20}, {10, 12}};
+
+template <typename T>
+static void checkMedianArguments(const ImageView<const T> &image, int kernelSize)
+{
+    if (image.empty())
+    {
+        throw invalid_argument("Image is empty");
+    }
+    if (image.channels() != 1)
+    {
+        throw invalid_argument("Median filter needs a single-channel image");
+    }
+    if (kernelSize < 1 || kernelSize % 2 == 0)
+    {
+        throw invalid_argument("Invalid kernel size");
+    }
+}
+
+static inline size_t clampIndex(ptrdiff_t i, size_t size)
+{
+    return i < 0 ? 0 : (static_cast<size_t>(i) >= size ? size - 1 : static_cast<size_t>(i));
+}
+
+template <typename T>
+Image<T> MedianFilter<T>::apply(const ImageView<const T> &image, int kernelSize, ThreadPool &pool)
+{
+    checkMedianArguments(image, kernelSize);
+    if (kernelSize == 1)
+    {
+        return copyImage(image);
+    }
+    if (kernelSize == 3 || kernelSize == 5)
+    {
+        return applySortingNetwork(image, kernelSize, pool);
+    }
+    return applyHistogram(image, kernelSize, pool);
+}
+
+//--------------------------------------------------
+// Sorting networks
+//--------------------------------------------------
+
+template <typename T>
+Image<T> MedianFilter<T>::applySortingNetwork(const ImageView<const T> &image, int kernelSize, ThreadPool &pool)
+{
+    checkMedianArguments(image, kernelSize);
+    if (kernelSize != 3 && kernelSize != 5)
+    {
+        throw invalid_argument("Sorting networks cover 3 x 3 and 5 x 5 windows only");
+    }
+    const CompareExchange *network = kernelSize == 3 ? MEDIAN9_NETWORK : MEDIAN25_NETWORK;
+    const size_t networkLength = kernelSize == 3 ? size(MEDIAN9_NETWORK) : size(MEDIAN25_NETWORK);
+    const size_t taps = static_cast<size_t>(kernelSize) * kernelSize;
+    const size_t median = taps / 2;
+
+    size_t width = image.width();
+    size_t height = image.height();
+    size_t half = kernelSize / 2;
+    Image<T> output(width, height);
+    pool.parallelFor(0, height, [&](size_t first, size_t last) {
+        // Each window row widened with replicated edges, and the taps of a
+        // strip laid out tap-major: window[t * NETWORK_STRIP + i] is tap t
+        // of pixel i.
+        vector<T> lines(kernelSize * (width + 2 * half));
+        vector<T> window(taps * NETWORK_STRIP);
+        for (size_t y = first; y < last; y++)
+        {
+            ptrdiff_t top = static_cast<ptrdiff_t>(y) - static_cast<ptrdiff_t>(half);
+            for (int m = 0; m < kernelSize; m++)
+            {
+                const T *source = image.row(clampIndex(top + m, height));
+                T *line = lines.data() + m * (width + 2 * half);
+                fill(line, line + half, source[0]);
+                copy(source, source + width, line + half);
+                fill(line + half + width, line + 2 * half + width, source[width - 1]);
+            }
+            T *outRow = output.row(y);
+            for (size_t x0 = 0; x0 < width; x0 += NETWORK_STRIP)
+            {
+                size_t count = min(NETWORK_STRIP, width - x0);
+                for (int m = 0; m < kernelSize; m++)
+                {
+                    const T *line = lines.data() + m * (width + 2 * half) + x0;
+                    for (int n = 0; n < kernelSize; n++)
+                    {
+                        copy(line + n, line + n + count, window.data() + (m * kernelSize + n) * NETWORK_STRIP);
+                    }
+                }
+                for (size_t s = 0; s < networkLength; s++)
+                {
+                    T *low = window.data() + network[s].low * NETWORK_STRIP;
+                    T *high = window.data() + network[s].high * NETWORK_STRIP;
+                    for (size_t i = 0; i < count; i++)
+                    {
+                        // Written with a saturating difference, which
+                        // SSE2 has for 16-bit lanes where it lacks min/max.
+                        T a = low[i];
+                        T b = high[i];
+                        T excess = a > b ? T(a - b) : T(0);
+                        low[i] = T(a - excess);
+                        high[i] = T(b + excess);
+                    }
+                }
+                copy(window.data() + median * NETWORK_STRIP, window.data() + median * NETWORK_STRIP + count,
+                     outRow + x0);
+            }
+        }
+    });
+    return output;
+}
+
+//--------------------------------------------------
+// Constant-time histogram median
+//--------------------------------------------------
+
+// Histogram geometry for T: the coarse level indexes the high half of the
+// bits, the fine level every value, stored so that the fine bins of one
+// coarse bin are contiguous.
+template <typename T>
+struct MedianHistogramLayout
+{
+    static const int FINE_BITS = 4 * sizeof(T);
+    static const size_t FINE_PER_COARSE = size_t(1) << FINE_BITS;
+    static const size_t COARSE_BINS = size_t(1) << (8 * sizeof(T) - FINE_BITS);
+    static const size_t BINS = COARSE_BINS * FINE_PER_COARSE;
+};
+
+// Output columns [stripeBegin, stripeEnd) of rows [first, last).
+template <typename T>
+static void histogramMedianStripe(const ImageView<const T> &image, int kernelSize, size_t first, size_t last,
+                                  size_t stripeBegin, size_t stripeEnd, Image<T> &output)
+{
+    using Layout = MedianHistogramLayout<T>;
+    const size_t fineBits = Layout::FINE_BITS;
+    const size_t finePerCoarse = Layout::FINE_PER_COARSE;
+    const size_t coarseBins = Layout::COARSE_BINS;
+    const size_t bins = Layout::BINS;
+
+    size_t width = image.width();
+    size_t height = image.height();
+    ptrdiff_t half = kernelSize / 2;
+    uint32_t rank = static_cast<uint32_t>(kernelSize) * kernelSize / 2;
+
+    // Column histograms for every image column the stripe's windows touch.
+    // A column holds at most kernelSize samples, so 16-bit counts suffice.
+    // The fine counts are grouped by coarse bin first and column second, so
+    // bringing one coarse bin of the window up to date reads neighbouring
+    // columns from contiguous memory.
+    size_t columnBegin = clampIndex(static_cast<ptrdiff_t>(stripeBegin) - half, width);
+    size_t columnEnd = clampIndex(static_cast<ptrdiff_t>(stripeEnd - 1) + half, width) + 1;
+    size_t columns = columnEnd - columnBegin;
+    vector<uint16_t> columnCoarse(columns * coarseBins, 0);
+    vector<uint16_t> columnFine(columns * bins, 0);
+    auto addRow = [&](size_t y, int delta)
+    {
+        const T *row = image.row(y);
+        for (size_t c = columnBegin; c < columnEnd; c++)
+        {
+            size_t value = row[c];
+            columnCoarse[(c - columnBegin) * coarseBins + (value >> fineBits)] += delta;
+            columnFine[((value >> fineBits) * columns + (c - columnBegin)) * finePerCoarse +
+                       (value & (finePerCoarse - 1))] += delta;
+        }
+    };
+    for (ptrdiff_t m = -half; m <= half; m++)
+    {
+        addRow(clampIndex(static_cast<ptrdiff_t>(first) + m, height), 1);
+    }
+
+    // Window histogram. fineSynced[b] is the column at which the fine
+    // counts of coarse bin b were last brought up to date, or -1.
+    vector<uint32_t> coarse(coarseBins);
+    vector<uint32_t> fine(bins);
+    vector<ptrdiff_t> fineSynced(coarseBins);
+    auto columnIndex = [&](ptrdiff_t x) { return clampIndex(x, width) - columnBegin; };
+    auto addFine = [&](size_t bin, size_t column, int sign)
+    {
+        const uint16_t *source = columnFine.data() + (bin * columns + column) * finePerCoarse;
+        uint32_t *target = fine.data() + bin * finePerCoarse;
+        for (size_t f = 0; f < finePerCoarse; f++)
+        {
+            target[f] += sign * static_cast<int32_t>(source[f]);
+        }
+    };
+
+    for (size_t y = first; y < last; y++)
+    {
+        if (y > first)
+        {
+            size_t leaving = clampIndex(static_cast<ptrdiff_t>(y) - half - 1, height);
+            size_t entering = clampIndex(static_cast<ptrdiff_t>(y) + half, height);
+            if (leaving != entering)
+            {
+                addRow(leaving, -1);
+                addRow(entering, 1);
+            }
+        }
+
+        fill(coarse.begin(), coarse.end(), 0u);
+        fill(fineSynced.begin(), fineSynced.end(), ptrdiff_t(-1));
+        for (ptrdiff_t n = -half; n <= half; n++)
+        {
+            const uint16_t *source =
+                columnCoarse.data() + columnIndex(static_cast<ptrdiff_t>(stripeBegin) + n) * coarseBins;
+            for (size_t b = 0; b < coarseBins; b++)
+            {
+                coarse[b] += source[b];
+            }
+        }
+
+        T *outRow = output.row(y);
+        for (size_t x = stripeBegin; x < stripeEnd; x++)
+        {
+            ptrdiff_t sx = static_cast<ptrdiff_t>(x);
+            if (x > stripeBegin)
+            {
+                const uint16_t *entering = columnCoarse.data() + columnIndex(sx + half) * coarseBins;
+                const uint16_t *leaving = columnCoarse.data() + columnIndex(sx - half - 1) * coarseBins;
+                for (size_t b = 0; b < coarseBins; b++)
+                {
+                    coarse[b] += static_cast<int32_t>(entering[b]) - static_cast<int32_t>(leaving[b]);
+                }
+            }
+
+            size_t bin = 0;
+            uint32_t below = 0;
+            while (below + coarse[bin] <= rank)
+            {
+                below += coarse[bin++];
+            }
+
+            // Bring the fine counts of this coarse bin to column x: replay
+            // the columns that entered and left since the last sync, or
+            // rebuild from the window when that would take longer.
+            ptrdiff_t synced = fineSynced[bin];
+            if (synced < 0 || sx - synced >= kernelSize)
+            {
+                fill(fine.begin() + bin * finePerCoarse, fine.begin() + (bin + 1) * finePerCoarse, 0u);
+                for (ptrdiff_t n = -half; n <= half; n++)
+                {
+                    addFine(bin, columnIndex(sx + n), 1);
+                }
+            }
+            else
+            {
+                for (ptrdiff_t t = synced + 1; t <= sx; t++)
+                {
+                    addFine(bin, columnIndex(t + half), 1);
+                    addFine(bin, columnIndex(t - half - 1), -1);
+                }
+            }
+            fineSynced[bin] = sx;
+
+            const uint32_t *counts = fine.data() + bin * finePerCoarse;
+            size_t f = 0;
+            while (below + counts[f] <= rank)
+            {
+                below += counts[f++];
+            }
+            outRow[x] = static_cast<T>((bin << fineBits) + f);
+        }
+    }
+}
+
+template <typename T>
+Image<T> MedianFilter<T>::applyHistogram(const ImageView<const T> &image, int kernelSize, ThreadPool &pool)
+{
+    checkMedianArguments(image, kernelSize);
+    if (kernelSize > numeric_limits<uint16_t>::max())
+    {
+        throw invalid_argument("Kernel too large for the column histograms");
+    }
+
+    size_t width = image.width();
+    size_t height = image.height();
+    size_t columnBytes = MedianHistogramLayout<T>::BINS * sizeof(uint16_t);
+    size_t budgetColumns = MEDIAN_HISTOGRAM_BUDGET / columnBytes;
+    size_t halo = static_cast<size_t>(kernelSize) - 1;
+    size_t stripeWidth = budgetColumns > halo + MIN_STRIPE_WIDTH ? budgetColumns - halo : MIN_STRIPE_WIDTH;
+
+    Image<T> output(width, height);
+    pool.parallelFor(0, height, [&](size_t first, size_t last) {
+        for (size_t x = 0; x < width; x += stripeWidth)
+        {
+            histogramMedianStripe(image, kernelSize, first, last, x, min(width, x + stripeWidth), output);
+        }
+    });
+    return output;
+}
+
+#endif // MEDIANFILTER_CPP
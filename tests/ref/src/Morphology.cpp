@@ -0,0 +1,235 @@
+#ifndef MORPHOLOGY_CPP
+#define MORPHOLOGY_CPP
+
+#include "Morphology.hpp"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+template class Morphology<uint8_t>;
+template class Morphology<uint16_t>;
+template class Morphology<uint32_t>;
+template class Morphology<uint64_t>;
+
+// Bytes of each row a vertical pass handles at once; its forward and
+// backward buffers are two strips of this width by the padded height.
+static const size_t MORPHOLOGY_STRIP_BYTES = 256;
+
+template <typename T>
+struct MinimumOf
+{
+    static T neutral() { return numeric_limits<T>::max(); }
+    T operator()(T a, T b) const { return min(a, b); }
+};
+
+template <typename T>
+struct MaximumOf
+{
+    static T neutral() { return numeric_limits<T>::min(); }
+    T operator()(T a, T b) const { return max(a, b); }
+};
+
+template <typename T>
+static void checkMorphologyArguments(const ImageView<const T> &image, int width, int height)
+{
+    if (image.empty())
+    {
+        throw invalid_argument("Image is empty");
+    }
+    if (width < 1 || height < 1 || width % 2 == 0 || height % 2 == 0)
+    {
+        throw invalid_argument("Invalid structuring element size");
+    }
+}
+
+// A line of `count` samples padded by window / 2 neutral samples on each
+// side, and then up to a whole number of blocks of `window`.
+static size_t paddedLength(size_t count, size_t window)
+{
+    size_t length = count + window - 1;
+    return (length + window - 1) / window * window;
+}
+
+// Horizontal pass: every row, one channel at a time.
+template <typename T, typename Op>
+static void vanHerkRows(const ImageView<const T> &image, size_t window, Image<T> &output, ThreadPool &pool)
+{
+    const Op op;
+    size_t width = image.width();
+    size_t channels = image.channels();
+    size_t half = window / 2;
+    size_t length = paddedLength(width, window);
+    pool.parallelFor(0, image.height(), [&](size_t first, size_t last) {
+        vector<T> line(length), forward(length), backward(length);
+        for (size_t i = first; i < last; i++)
+        {
+            const T *inRow = image.row(i);
+            T *outRow = output.row(i);
+            for (size_t c = 0; c < channels; c++)
+            {
+                fill(line.begin(), line.end(), Op::neutral());
+                for (size_t x = 0; x < width; x++)
+                {
+                    line[half + x] = inRow[x * channels + c];
+                }
+                for (size_t block = 0; block < length; block += window)
+                {
+                    size_t end = block + window - 1;
+                    forward[block] = line[block];
+                    for (size_t j = block + 1; j <= end; j++)
+                    {
+                        forward[j] = op(forward[j - 1], line[j]);
+                    }
+                    backward[end] = line[end];
+                    for (size_t j = end; j-- > block;)
+                    {
+                        backward[j] = op(backward[j + 1], line[j]);
+                    }
+                }
+                // Window x spans line[x] ... line[x + window - 1]: the tail
+                // of one block and the head of the next.
+                for (size_t x = 0; x < width; x++)
+                {
+                    outRow[x * channels + c] = op(backward[x], forward[x + window - 1]);
+                }
+            }
+        }
+    });
+}
+
+// Vertical pass over strips of columns, a whole strip row at a time so the
+// forward and backward recurrences run along contiguous memory.
+template <typename T, typename Op>
+static void vanHerkColumns(const ImageView<const T> &image, size_t window, Image<T> &output, ThreadPool &pool)
+{
+    const Op op;
+    size_t height = image.height();
+    size_t rowLength = image.rowLength();
+    size_t half = window / 2;
+    size_t length = paddedLength(height, window);
+    size_t strip = max<size_t>(1, MORPHOLOGY_STRIP_BYTES / sizeof(T));
+    size_t strips = (rowLength + strip - 1) / strip;
+    pool.parallelFor(0, strips, [&](size_t first, size_t last) {
+        vector<T> forward(length * strip), backward(length * strip);
+        vector<T> neutralRow(strip, Op::neutral());
+        for (size_t s = first; s < last; s++)
+        {
+            size_t begin = s * strip;
+            size_t count = min(strip, rowLength - begin);
+            auto source = [&](size_t j) {
+                return j >= half && j - half < height ? image.row(j - half) + begin : neutralRow.data();
+            };
+            for (size_t j = 0; j < length; j++)
+            {
+                const T *in = source(j);
+                T *current = forward.data() + j * strip;
+                if (j % window == 0)
+                {
+                    copy(in, in + count, current);
+                    continue;
+                }
+                const T *previous = current - strip;
+                for (size_t x = 0; x < count; x++)
+                {
+                    current[x] = op(previous[x], in[x]);
+                }
+            }
+            for (size_t j = length; j-- > 0;)
+            {
+                const T *in = source(j);
+                T *current = backward.data() + j * strip;
+                if ((j + 1) % window == 0)
+                {
+                    copy(in, in + count, current);
+                    continue;
+                }
+                const T *next = current + strip;
+                for (size_t x = 0; x < count; x++)
+                {
+                    current[x] = op(next[x], in[x]);
+                }
+            }
+            for (size_t y = 0; y < height; y++)
+            {
+                const T *tail = backward.data() + y * strip;
+                const T *head = forward.data() + (y + window - 1) * strip;
+                T *outRow = output.row(y) + begin;
+                for (size_t x = 0; x < count; x++)
+                {
+                    outRow[x] = op(tail[x], head[x]);
+                }
+            }
+        }
+    });
+}
+
+template <typename T, typename Op>
+static Image<T> vanHerk(const ImageView<const T> &image, int width, int height, ThreadPool &pool)
+{
+    checkMorphologyArguments(image, width, height);
+    Image<T> rows(image.width(), image.height(), image.channels());
+    vanHerkRows<T, Op>(image, width, rows, pool);
+    Image<T> output(image.width(), image.height(), image.channels());
+    vanHerkColumns<T, Op>(rows.cview(), height, output, pool);
+    return output;
+}
+
+// minuend - subtrahend, sample by sample; callers guarantee no underflow.
+template <typename T>
+static Image<T> difference(const ImageView<const T> &minuend, const ImageView<const T> &subtrahend)
+{
+    Image<T> output(minuend.width(), minuend.height(), minuend.channels());
+    size_t rowLength = minuend.rowLength();
+    for (uint32_t i = 0; i < minuend.height(); i++)
+    {
+        const T *a = minuend.row(i);
+        const T *b = subtrahend.row(i);
+        T *outRow = output.row(i);
+        for (size_t x = 0; x < rowLength; x++)
+        {
+            outRow[x] = static_cast<T>(a[x] - b[x]);
+        }
+    }
+    return output;
+}
+
+template <typename T>
+Image<T> Morphology<T>::erode(const ImageView<const T> &image, int width, int height, ThreadPool &pool)
+{
+    return vanHerk<T, MinimumOf<T>>(image, width, height, pool);
+}
+
+template <typename T>
+Image<T> Morphology<T>::dilate(const ImageView<const T> &image, int width, int height, ThreadPool &pool)
+{
+    return vanHerk<T, MaximumOf<T>>(image, width, height, pool);
+}
+
+template <typename T>
+Image<T> Morphology<T>::open(const ImageView<const T> &image, int width, int height, ThreadPool &pool)
+{
+    return dilate(erode(image, width, height, pool).cview(), width, height, pool);
+}
+
+template <typename T>
+Image<T> Morphology<T>::close(const ImageView<const T> &image, int width, int height, ThreadPool &pool)
+{
+    return erode(dilate(image, width, height, pool).cview(), width, height, pool);
+}
+
+// With outside samples neutral, opening never exceeds the image and closing
+// never falls below it, so neither difference can wrap.
+template <typename T>
+Image<T> Morphology<T>::topHat(const ImageView<const T> &image, int width, int height, ThreadPool &pool)
+{
+    return difference(image, open(image, width, height, pool).cview());
+}
+
+template <typename T>
+Image<T> Morphology<T>::blackTopHat(const ImageView<const T> &image, int width, int height, ThreadPool &pool)
+{
+    return difference(close(image, width, height, pool).cview(), image);
+}
+
+#endif // MORPHOLOGY_CPP
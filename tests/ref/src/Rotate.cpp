@@ -3,6 +3,7 @@
 
 /* Rotate.cpp */
 #include "Rotate.hpp"
+#include <algorithm>
 
 template class ImageRotator<uint8_t>;
 template class ImageRotator<uint16_t>;
@@ -17,80 +18,138 @@ void ImageRotator<T>::rotate(Image<T> &image, RotationDirection direction)
         throw RotationError("Invalid image dimensions for rotation.");
     }
 
-    if (image.pixelMatrix.empty())
+    if (image.empty())
     {
-        throw RotationError("Pixel matrix is empty, cannot rotate image.");
+        throw RotationError("Pixel buffer is empty, cannot rotate image.");
     }
 
     switch (direction)
     {
     case RotationDirection::CW_90:
-        rotate90CW(image.pixelMatrix);
+        image.reorient(Orientation::rotatedClockwise(1));
         break;
     case RotationDirection::CCW_90:
-        rotate90CCW(image.pixelMatrix);
+        image.reorient(Orientation::rotatedClockwise(3));
         break;
     case RotationDirection::ROTATE_180:
-        rotate180(image.pixelMatrix);
+        image.reorient(Orientation::rotatedClockwise(2));
         break;
     default:
         throw RotationError("Unsupported rotation direction.");
     }
-
-    image.metadata.width = image.pixelMatrix[0].size();
-    image.metadata.height = image.pixelMatrix.size();
 }
 
 template <typename T>
-void ImageRotator<T>::rotate90CW(vector<vector<T>> &matrix)
+void ImageRotator<T>::rotate(const ImageView<const T> &src, const ImageView<T> &dst, RotationDirection direction)
 {
-    size_t newHeight = matrix[0].size();
-    size_t newWidth = matrix.size();
-    vector<vector<T>> rotated(newHeight, vector<T>(newWidth));
+    if (src.empty() || dst.empty())
+    {
+        throw RotationError("Invalid image dimensions for rotation.");
+    }
+    if (src.channels() != 1 || dst.channels() != 1)
+    {
+        throw RotationError("Rotation supports single-channel images only.");
+    }
 
-    for (size_t i = 0; i < newWidth; ++i)
+    switch (direction)
     {
-        for (size_t j = 0; j < newHeight; ++j)
+    case RotationDirection::CW_90:
+    case RotationDirection::CCW_90:
+        if (dst.width() != src.height() || dst.height() != src.width())
         {
-            rotated[j][newWidth - 1 - i] = matrix[i][j];
+            throw RotationError("Destination dimensions do not match rotated image.");
         }
+        if (direction == RotationDirection::CW_90)
+            rotate90CW(src, dst);
+        else
+            rotate90CCW(src, dst);
+        break;
+    case RotationDirection::ROTATE_180:
+        if (dst.width() != src.width() || dst.height() != src.height())
+        {
+            throw RotationError("Destination dimensions do not match rotated image.");
+        }
+        copyPixels(src, dst);
+        rotate180(dst);
+        break;
+    default:
+        throw RotationError("Unsupported rotation direction.");
     }
-
-    matrix = move(rotated);
 }
 
+// Source rows / columns per tile of the 90-degree turns: a tile's source
+// rows and destination rows both stay in L1 while it is copied, so each
+// cache line on either side is fetched once instead of once per pixel.
+static const size_t ROTATION_TILE = 32;
+
+// dst(j, rows - 1 - i) = src(i, j), tile by tile. Within a tile the
+// destination is written a row at a time.
 template <typename T>
-void ImageRotator<T>::rotate90CCW(vector<vector<T>> &matrix)
+void ImageRotator<T>::rotate90CW(const ImageView<const T> &src, const ImageView<T> &dst)
 {
-    size_t newHeight = matrix[0].size();
-    size_t newWidth = matrix.size();
-    vector<vector<T>> rotated(newHeight, vector<T>(newWidth));
-
-    for (size_t i = 0; i < newWidth; ++i)
+    size_t rows = src.height();
+    size_t cols = src.width();
+    for (size_t i0 = 0; i0 < rows; i0 += ROTATION_TILE)
     {
-        for (size_t j = 0; j < newHeight; ++j)
+        size_t iEnd = min(rows, i0 + ROTATION_TILE);
+        for (size_t j0 = 0; j0 < cols; j0 += ROTATION_TILE)
         {
-            rotated[newHeight - 1 - j][i] = matrix[i][j];
+            size_t jEnd = min(cols, j0 + ROTATION_TILE);
+            for (size_t j = j0; j < jEnd; ++j)
+            {
+                T *dstRow = dst.row(j) + rows - 1;
+                for (size_t i = i0; i < iEnd; ++i)
+                {
+                    dstRow[-static_cast<ptrdiff_t>(i)] = src.row(i)[j];
+                }
+            }
         }
     }
-
-    matrix = move(rotated);
 }
 
+// dst(cols - 1 - j, i) = src(i, j), tile by tile.
 template <typename T>
-void ImageRotator<T>::rotate180(vector<vector<T>> &matrix)
+void ImageRotator<T>::rotate90CCW(const ImageView<const T> &src, const ImageView<T> &dst)
 {
-    size_t row = matrix.size();
-    size_t col = matrix[0].size();
-    for (size_t i = 0; i < row / 2; i++)
+    size_t rows = src.height();
+    size_t cols = src.width();
+    for (size_t i0 = 0; i0 < rows; i0 += ROTATION_TILE)
     {
-        for (size_t j = 0; j < col; j++)
+        size_t iEnd = min(rows, i0 + ROTATION_TILE);
+        for (size_t j0 = 0; j0 < cols; j0 += ROTATION_TILE)
         {
-            if (i == row - i - 1 && j >= (col - i) / 2)
-                break;
-            swap(matrix[i][j], matrix[row - i - 1][col - j - 1]);
+            size_t jEnd = min(cols, j0 + ROTATION_TILE);
+            for (size_t j = j0; j < jEnd; ++j)
+            {
+                T *dstRow = dst.row(cols - 1 - j);
+                for (size_t i = i0; i < iEnd; ++i)
+                {
+                    dstRow[i] = src.row(i)[j];
+                }
+            }
         }
     }
 }
 
+// Top and bottom rows are exchanged and each reversed; an odd middle row
+// is only reversed.
+template <typename T>
+void ImageRotator<T>::rotate180(const ImageView<T> &image)
+{
+    size_t rows = image.height();
+    size_t cols = image.width();
+    for (size_t i = 0; i < rows / 2; i++)
+    {
+        T *top = image.row(i);
+        T *bottom = image.row(rows - 1 - i);
+        swap_ranges(top, top + cols, bottom);
+        reverseSamples(top, cols);
+        reverseSamples(bottom, cols);
+    }
+    if (rows % 2 == 1)
+    {
+        reverseSamples(image.row(rows / 2), cols);
+    }
+}
+
 #endif // ROTATE_CPP
@@ -0,0 +1,376 @@
+#ifndef WARP_CPP
+#define WARP_CPP
+
+#include "Warp.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+template class ImageWarper<uint8_t>;
+template class ImageWarper<uint16_t>;
+template class ImageWarper<uint32_t>;
+template class ImageWarper<uint64_t>;
+
+AffineTransform AffineTransform::translation(double dx, double dy)
+{
+    AffineTransform transform;
+    transform.c = dx;
+    transform.f = dy;
+    return transform;
+}
+
+AffineTransform AffineTransform::rotation(double degrees, double centreX, double centreY)
+{
+    double radians = degrees * M_PI / 180.0;
+    AffineTransform turn;
+    turn.a = cos(radians);
+    turn.b = -sin(radians);
+    turn.d = sin(radians);
+    turn.e = cos(radians);
+    return translation(-centreX, -centreY).then(turn).then(translation(centreX, centreY));
+}
+
+AffineTransform AffineTransform::scaling(double scaleX, double scaleY, double centreX, double centreY)
+{
+    AffineTransform scale;
+    scale.a = scaleX;
+    scale.e = scaleY;
+    return translation(-centreX, -centreY).then(scale).then(translation(centreX, centreY));
+}
+
+AffineTransform AffineTransform::shear(double shearX, double shearY, double centreX, double centreY)
+{
+    AffineTransform skew;
+    skew.b = shearX;
+    skew.d = shearY;
+    return translation(-centreX, -centreY).then(skew).then(translation(centreX, centreY));
+}
+
+AffineTransform AffineTransform::then(const AffineTransform &next) const
+{
+    AffineTransform combined;
+    combined.a = next.a * a + next.b * d;
+    combined.b = next.a * b + next.b * e;
+    combined.c = next.a * c + next.b * f + next.c;
+    combined.d = next.d * a + next.e * d;
+    combined.e = next.d * b + next.e * e;
+    combined.f = next.d * c + next.e * f + next.f;
+    return combined;
+}
+
+AffineTransform AffineTransform::inverse() const
+{
+    double determinant = a * e - b * d;
+    if (!(fabs(determinant) > 1e-12) || !isfinite(determinant))
+    {
+        throw invalid_argument("Affine transform is not invertible");
+    }
+    AffineTransform inverted;
+    inverted.a = e / determinant;
+    inverted.b = -b / determinant;
+    inverted.d = -d / determinant;
+    inverted.e = a / determinant;
+    inverted.c = -(inverted.a * c + inverted.b * f);
+    inverted.f = -(inverted.d * c + inverted.e * f);
+    return inverted;
+}
+
+// Output tile size. Tiles are wide so each output row segment and the
+// input lines under it are long enough for the prefetcher, and short
+// enough that the input a steep angle walks across still fits in L2.
+static const size_t WARP_TILE_WIDTH = 256;
+static const size_t WARP_TILE_HEIGHT = 32;
+// Input positions are stepped in 32.32 fixed point; over a tile row the
+// accumulated rounding of the step stays below 2^-24 pixel.
+static const int WARP_FRACTION_BITS = 32;
+// 8-bit images take their interpolation weights from tables every 1/256
+// pixel, which moves a result by at most half a level. Wider samples would
+// need far finer tables; their weights are computed from the whole 32-bit
+// fraction instead.
+static const int WARP_WEIGHT_BITS = 8;
+static const int WARP_WEIGHT_LEVELS = 1 << WARP_WEIGHT_BITS;
+// Positions and steps are clamped to this many pixels so the fixed-point
+// values cannot overflow; anything that far out reads the border anyway.
+static const double WARP_POSITION_LIMIT = 1 << 28;
+static const double WARP_STEP_LIMIT = 1 << 20;
+
+static int64_t toFixed(double value, double limit)
+{
+    value = min(max(value, -limit), limit);
+    return llround(value * static_cast<double>(int64_t(1) << WARP_FRACTION_BITS));
+}
+
+// Keys' cubic convolution kernel with a = -0.5.
+static double cubicWeight(double distance)
+{
+    const double a = -0.5;
+    distance = fabs(distance);
+    if (distance <= 1.0)
+    {
+        return ((a + 2.0) * distance - (a + 3.0)) * distance * distance + 1.0;
+    }
+    if (distance < 2.0)
+    {
+        return ((a * distance - 5.0 * a) * distance + 8.0 * a) * distance - 4.0 * a;
+    }
+    return 0.0;
+}
+
+// Taps' weights for a position `fraction` of a pixel past the sample left
+// of (above) it; taps sit at offsets 0, 1 (bilinear) or -1, 0, 1, 2
+// (bicubic) from that sample.
+template <typename A, int Taps>
+static inline void tapWeights(double fraction, A *weights)
+{
+    if (Taps == 1)
+    {
+        weights[0] = A(1);
+    }
+    else if (Taps == 2)
+    {
+        weights[0] = static_cast<A>(1.0 - fraction);
+        weights[1] = static_cast<A>(fraction);
+    }
+    else
+    {
+        for (int t = 0; t < Taps; t++)
+        {
+            weights[t] = static_cast<A>(cubicWeight(fraction - (t - 1)));
+        }
+    }
+}
+
+// tapWeights for every tabulated fraction.
+template <typename A, int Taps>
+static vector<A> weightTable()
+{
+    vector<A> table(static_cast<size_t>(WARP_WEIGHT_LEVELS) * Taps);
+    for (int level = 0; level < WARP_WEIGHT_LEVELS; level++)
+    {
+        tapWeights<A, Taps>(static_cast<double>(level) / WARP_WEIGHT_LEVELS, table.data() + level * Taps);
+    }
+    return table;
+}
+
+template <typename T, typename A>
+static inline T clampSample(A value)
+{
+    if (!is_integral<T>::value)
+    {
+        return static_cast<T>(value);
+    }
+    value += A(0.5);
+    if (!(value > A(0)))
+    {
+        return T(0);
+    }
+    const A largest = static_cast<A>(numeric_limits<T>::max());
+    return value >= largest ? numeric_limits<T>::max() : static_cast<T>(value);
+}
+
+// First tap and fraction for a fixed-point position: the nearest sample
+// for one tap, otherwise the sample left of the position (one more to the
+// left for four taps) and the fraction rounded to `WeightBits` bits.
+template <int Taps, int WeightBits>
+static inline void locateTaps(int64_t position, ptrdiff_t &first, size_t &level)
+{
+    if (Taps == 1)
+    {
+        first = static_cast<ptrdiff_t>((position + (int64_t(1) << (WARP_FRACTION_BITS - 1))) >> WARP_FRACTION_BITS);
+        level = 0;
+        return;
+    }
+    if (WeightBits < WARP_FRACTION_BITS)
+    {
+        position += int64_t(1) << (WARP_FRACTION_BITS - WeightBits - 1);
+    }
+    first = static_cast<ptrdiff_t>(position >> WARP_FRACTION_BITS) - (Taps / 2 - 1);
+    level = static_cast<size_t>(position >> (WARP_FRACTION_BITS - WeightBits)) & ((int64_t(1) << WeightBits) - 1);
+}
+
+// One output tile, rows i0 .. iEnd - 1 and columns j0 .. jEnd - 1.
+// Everything arrives by value so the loop keeps it in registers; with
+// byte-sized T every store could otherwise alias it.
+template <typename T, typename A, int Taps>
+static void warpTile(ImageView<const T> image, AffineTransform inverse, ImageView<T> out, const A *weights,
+                     BorderMode border, size_t i0, size_t iEnd, size_t j0, size_t jEnd)
+{
+    constexpr bool tabulated = sizeof(T) == 1;
+    constexpr int weightBits = tabulated ? WARP_WEIGHT_BITS : WARP_FRACTION_BITS;
+    const double fractionUnit = 1.0 / static_cast<double>(int64_t(1) << WARP_FRACTION_BITS);
+    A exactX[Taps], exactY[Taps];
+    const ptrdiff_t inWidth = image.width();
+    const ptrdiff_t inHeight = image.height();
+    const size_t channels = image.channels();
+    const ptrdiff_t stride = static_cast<ptrdiff_t>(image.stride());
+    const int64_t stepX = toFixed(inverse.a, WARP_STEP_LIMIT);
+    const int64_t stepY = toFixed(inverse.d, WARP_STEP_LIMIT);
+    const T *rows[Taps];
+    ptrdiff_t columns[Taps];
+    for (size_t i = i0; i < iEnd; i++)
+    {
+        pair<double, double> start = inverse.apply(static_cast<double>(j0), static_cast<double>(i));
+        int64_t x = toFixed(start.first, WARP_POSITION_LIMIT);
+        int64_t y = toFixed(start.second, WARP_POSITION_LIMIT);
+        T *outRow = out.row(i);
+        for (size_t j = j0; j < jEnd; j++, x += stepX, y += stepY)
+        {
+            ptrdiff_t left, top;
+            size_t levelX, levelY;
+            locateTaps<Taps, weightBits>(x, left, levelX);
+            locateTaps<Taps, weightBits>(y, top, levelY);
+            const A *weightsX = exactX;
+            const A *weightsY = exactY;
+            if (tabulated)
+            {
+                weightsX = weights + levelX * Taps;
+                weightsY = weights + levelY * Taps;
+            }
+            else
+            {
+                tapWeights<A, Taps>(levelX * fractionUnit, exactX);
+                tapWeights<A, Taps>(levelY * fractionUnit, exactY);
+            }
+            T *outPixel = outRow + j * channels;
+
+            // Footprint wholly inside: plain strided reads.
+            if (left >= 0 && top >= 0 && left + Taps <= inWidth && top + Taps <= inHeight)
+            {
+                const T *corner = image.data() + top * stride + left * static_cast<ptrdiff_t>(channels);
+                for (size_t c = 0; c < channels; c++)
+                {
+                    if (Taps == 1)
+                    {
+                        outPixel[c] = corner[c];
+                        continue;
+                    }
+                    A sum = A(0);
+                    for (int ty = 0; ty < Taps; ty++)
+                    {
+                        const T *tapRow = corner + ty * stride + c;
+                        A rowSum = A(0);
+                        for (int tx = 0; tx < Taps; tx++)
+                        {
+                            rowSum += weightsX[tx] * static_cast<A>(tapRow[tx * static_cast<ptrdiff_t>(channels)]);
+                        }
+                        sum += weightsY[ty] * rowSum;
+                    }
+                    outPixel[c] = clampSample<T>(sum);
+                }
+                continue;
+            }
+
+            // Otherwise each tap row and column goes through the
+            // border; -1 (ZERO) taps contribute nothing.
+            for (int t = 0; t < Taps; t++)
+            {
+                ptrdiff_t row = borderIndex(top + t, inHeight, border);
+                ptrdiff_t column = borderIndex(left + t, inWidth, border);
+                rows[t] = row < 0 ? nullptr : image.row(static_cast<uint32_t>(row));
+                columns[t] = column < 0 ? -1 : column * static_cast<ptrdiff_t>(channels);
+            }
+            for (size_t c = 0; c < channels; c++)
+            {
+                A sum = A(0);
+                for (int ty = 0; ty < Taps; ty++)
+                {
+                    if (!rows[ty])
+                    {
+                        continue;
+                    }
+                    A rowSum = A(0);
+                    for (int tx = 0; tx < Taps; tx++)
+                    {
+                        if (columns[tx] >= 0)
+                        {
+                            rowSum += weightsX[tx] * static_cast<A>(rows[ty][columns[tx] + c]);
+                        }
+                    }
+                    sum += weightsY[ty] * rowSum;
+                }
+                outPixel[c] = clampSample<T>(sum);
+            }
+        }
+    }
+}
+
+template <typename T, typename A, int Taps>
+static void warpTiles(const ImageView<const T> &image, const AffineTransform &inverse, Image<T> &output,
+                      const vector<A> &weights, BorderMode border, ThreadPool &pool)
+{
+    const size_t outWidth = output.metadata.width;
+    const size_t outHeight = output.metadata.height;
+    const size_t tilesAcross = (outWidth + WARP_TILE_WIDTH - 1) / WARP_TILE_WIDTH;
+    const size_t tilesDown = (outHeight + WARP_TILE_HEIGHT - 1) / WARP_TILE_HEIGHT;
+    ImageView<T> out = output.view();
+    pool.parallelFor(0, tilesAcross * tilesDown, [&](size_t firstTile, size_t lastTile) {
+        for (size_t tile = firstTile; tile < lastTile; tile++)
+        {
+            size_t i0 = tile / tilesAcross * WARP_TILE_HEIGHT;
+            size_t j0 = tile % tilesAcross * WARP_TILE_WIDTH;
+            warpTile<T, A, Taps>(image, inverse, out, weights.data(), border, i0, min(outHeight, i0 + WARP_TILE_HEIGHT),
+                                 j0, min(outWidth, j0 + WARP_TILE_WIDTH));
+        }
+    });
+}
+
+// The weight table warpTile reads, empty where weights are computed.
+template <typename T, typename A, int Taps>
+static vector<A> warpWeights()
+{
+    return sizeof(T) == 1 ? weightTable<A, Taps>() : vector<A>();
+}
+
+template <typename T>
+Image<T> ImageWarper<T>::warp(const ImageView<const T> &image, const AffineTransform &transform, uint32_t width,
+                              uint32_t height, Interpolation interpolation, BorderMode border, ThreadPool &pool)
+{
+    if (image.empty())
+    {
+        throw invalid_argument("Image is empty");
+    }
+    if (width == 0 || height == 0)
+    {
+        throw invalid_argument("Invalid output size");
+    }
+    AffineTransform inverse = transform.inverse();
+    Image<T> output(width, height, image.channels());
+
+    // float holds 8- and 16-bit sums with room to spare; wider samples need
+    // double.
+    using Accumulator = conditional_t<(sizeof(T) <= 2), float, double>;
+    switch (interpolation)
+    {
+    case Interpolation::NEAREST:
+        warpTiles<T, Accumulator, 1>(image, inverse, output, warpWeights<T, Accumulator, 1>(), border, pool);
+        break;
+    case Interpolation::BILINEAR:
+        warpTiles<T, Accumulator, 2>(image, inverse, output, warpWeights<T, Accumulator, 2>(), border, pool);
+        break;
+    case Interpolation::BICUBIC:
+        warpTiles<T, Accumulator, 4>(image, inverse, output, warpWeights<T, Accumulator, 4>(), border, pool);
+        break;
+    default:
+        throw invalid_argument("Unsupported interpolation");
+    }
+    return output;
+}
+
+template <typename T>
+Image<T> ImageWarper<T>::rotate(const ImageView<const T> &image, double degrees, Interpolation interpolation,
+                                BorderMode border, ThreadPool &pool)
+{
+    if (image.empty())
+    {
+        throw invalid_argument("Image is empty");
+    }
+    double centreX = (image.width() - 1) / 2.0;
+    double centreY = (image.height() - 1) / 2.0;
+    return warp(image, AffineTransform::rotation(degrees, centreX, centreY), image.width(), image.height(),
+                interpolation, border, pool);
+}
+
+#endif // WARP_CPP
@@ -8,6 +8,54 @@
 
 using namespace std;
 
+// Builds a single-channel image from nested rows.
+static Image<uint8_t> toImage(const vector<vector<uint8_t>> &rows) {
+    Image<uint8_t> image;
+    if (rows.empty()) {
+        return image;
+    }
+    image.allocate(rows[0].size(), rows.size());
+    for (size_t i = 0; i < rows.size(); i++) {
+        copy(rows[i].begin(), rows[i].end(), image.row(i));
+    }
+    return image;
+}
+
+// Builds an interleaved multi-channel image from [row][col][channel] data.
+static Image<uint8_t> toImage(const vector<vector<vector<uint8_t>>> &pixels) {
+    Image<uint8_t> image(pixels[0].size(), pixels.size(), pixels[0][0].size());
+    ImageView<uint8_t> view = image.view();
+    for (size_t i = 0; i < pixels.size(); i++) {
+        for (size_t j = 0; j < pixels[i].size(); j++) {
+            for (size_t c = 0; c < pixels[i][j].size(); c++) {
+                view(i, j, c) = pixels[i][j][c];
+            }
+        }
+    }
+    return image;
+}
+
+static vector<vector<uint8_t>> toRows(const Image<uint8_t> &image) {
+    vector<vector<uint8_t>> rows(image.metadata.height);
+    for (uint32_t i = 0; i < image.metadata.height; i++) {
+        rows[i].assign(image.row(i), image.row(i) + image.metadata.width);
+    }
+    return rows;
+}
+
+static vector<vector<vector<uint8_t>>> toPixels(const Image<uint8_t> &image) {
+    ImageView<const uint8_t> view = image.cview();
+    vector<vector<vector<uint8_t>>> pixels(view.height(), vector<vector<uint8_t>>(view.width(), vector<uint8_t>(view.channels())));
+    for (uint32_t i = 0; i < view.height(); i++) {
+        for (uint32_t j = 0; j < view.width(); j++) {
+            for (uint32_t c = 0; c < view.channels(); c++) {
+                pixels[i][j][c] = view(i, j, c);
+            }
+        }
+    }
+    return pixels;
+}
+
 
 TEST(BoxFilterTest, ApplyBoxFilterSuccess) {
     vector<vector<uint8_t>> image = {
@@ -26,7 +74,7 @@ TEST(BoxFilterTest, ApplyBoxFilterSuccess) {
     };
     BoxFilter boxFilter;
     int kernelSize = 3;
-    vector<vector<uint8_t>> result = boxFilter.applyBoxFilterFFT(image, kernelSize);     
+    vector<vector<uint8_t>> result = toRows(boxFilter.applyBoxFilterFFT(toImage(image).cview(), kernelSize));
         ASSERT_FALSE(result.empty());
         ASSERT_EQ(result.size(), image.size());
         ASSERT_EQ(result[0].size(), image[0].size());
@@ -45,7 +93,7 @@ TEST(BoxFilterTest, ApplyBoxFilterInvalidKernel) {
 
     try {
         BoxFilter boxFilter;
-        vector<vector<uint8_t>> result = boxFilter.applyBoxFilterFFT(image, kernelSize);
+        Image<uint8_t> result = boxFilter.applyBoxFilterFFT(toImage(image).cview(), kernelSize);
         FAIL() << "Expected an exception due to invalid kernel size.";
     } catch (const exception& e) {
         EXPECT_STREQ(e.what(), "Invalid kernel size");
@@ -61,7 +109,7 @@ TEST(BoxFilterTest, ApplyBoxFilterEmptyImage) {
 
     try {
         BoxFilter boxFilter;
-        vector<vector<uint8_t>> result = boxFilter.applyBoxFilterFFT(image, kernelSize);
+        Image<uint8_t> result = boxFilter.applyBoxFilterFFT(toImage(image).cview(), kernelSize);
         FAIL() << "Expected an exception due to empty image.";
     } catch (const exception& e) {
         EXPECT_STREQ(e.what(), "Image is empty");
@@ -89,7 +137,7 @@ TEST(BoxFilterTest, CorrectOutput) {
         {{14, 19, 23}, {25, 32, 38}, {32, 38, 45}, {38, 45, 52}, {28, 32, 37}}
     };
     BoxFilter boxFilter;
-    vector<vector<vector<uint8_t>>> result = boxFilter.applyBoxFilterSlidingRGB(inputImg, kernelSize);
+    vector<vector<vector<uint8_t>>> result = toPixels(boxFilter.applyBoxFilterSlidingRGB(toImage(inputImg).cview(), kernelSize));
     EXPECT_EQ(result, expectedOutput);
 }
 
@@ -112,7 +160,7 @@ TEST(BoxFilterTest, IncorrectOutput) {
         {{14, 19, 23}, {25, 32, 38}, {32, 38, 45}, {38, 45, 52}, {28, 32, 37}}
     };
     BoxFilter boxFilter;
-    vector<vector<vector<uint8_t>>> result = boxFilter.applyBoxFilterSlidingRGB(inputImg, kernelSize);
+    vector<vector<vector<uint8_t>>> result = toPixels(boxFilter.applyBoxFilterSlidingRGB(toImage(inputImg).cview(), kernelSize));
     EXPECT_EQ(result, incorrectOutput);
 }
 
@@ -127,7 +175,7 @@ TEST(BoxFilterTest, InvalidKernelSize) {
 
     int kernelSize = 11; 
     BoxFilter boxFilter;
-    vector<vector<vector<uint8_t>>> result = boxFilter.applyBoxFilterSlidingRGB(inputImg, kernelSize);
+    vector<vector<vector<uint8_t>>> result = toPixels(boxFilter.applyBoxFilterSlidingRGB(toImage(inputImg).cview(), kernelSize));
 }
 
 int main() {
@@ -0,0 +1,569 @@
+#ifndef CONVOLUTION_CPP
+#define CONVOLUTION_CPP
+
+#include "Convolution.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+template class Convolution<uint8_t>;
+template class Convolution<uint16_t>;
+template class Convolution<uint32_t>;
+template class Convolution<uint64_t>;
+
+ptrdiff_t borderIndex(ptrdiff_t i, ptrdiff_t n, BorderMode border)
+{
+    if (i >= 0 && i < n)
+    {
+        return i;
+    }
+    switch (border)
+    {
+    case BorderMode::REPLICATE:
+        return i < 0 ? 0 : n - 1;
+    case BorderMode::REFLECT:
+    {
+        if (n == 1)
+        {
+            return 0;
+        }
+        ptrdiff_t period = 2 * (n - 1);
+        i %= period;
+        if (i < 0)
+        {
+            i += period;
+        }
+        return i < n ? i : period - i;
+    }
+    case BorderMode::WRAP:
+        i %= n;
+        return i < 0 ? i + n : i;
+    case BorderMode::ZERO:
+    default:
+        return -1;
+    }
+}
+
+// Columns whose taps all fall inside the row are [interiorBegin,
+// interiorEnd); the rest are edge columns, and `sources` holds the
+// remapped column of every tap of each of them, left edge first.
+struct EdgeColumns
+{
+    size_t interiorBegin;
+    size_t interiorEnd;
+    size_t taps;
+    vector<ptrdiff_t> sources;
+
+    EdgeColumns(size_t width, size_t taps, BorderMode border) : taps(taps)
+    {
+        size_t half = taps / 2;
+        interiorBegin = min(half, width);
+        interiorEnd = max(interiorBegin, width > half ? width - half : 0);
+        for (size_t j = 0; j < width; j++)
+        {
+            if (j == interiorBegin)
+            {
+                j = interiorEnd;
+                if (j == width)
+                {
+                    break;
+                }
+            }
+            for (size_t t = 0; t < taps; t++)
+            {
+                ptrdiff_t column = static_cast<ptrdiff_t>(j + t) - static_cast<ptrdiff_t>(half);
+                sources.push_back(borderIndex(column, static_cast<ptrdiff_t>(width), border));
+            }
+        }
+    }
+
+    // Tap sources of edge column j.
+    const ptrdiff_t *of(size_t j) const
+    {
+        size_t slot = j < interiorBegin ? j : interiorBegin + (j - interiorEnd);
+        return sources.data() + slot * taps;
+    }
+};
+
+// sum + source[0] * weights[0] + ... in tap order. K is the tap count when
+// known at compile time, 0 when it is `taps`.
+template <int K, typename S>
+static inline double accumulateTaps(double sum, const S *source, const double *weights, size_t taps)
+{
+    const size_t count = K ? static_cast<size_t>(K) : taps;
+    for (size_t t = 0; t < count; t++)
+    {
+        sum += source[t] * weights[t];
+    }
+    return sum;
+}
+
+// The same for an edge column, through its remapped tap sources.
+template <typename S>
+static inline double accumulateEdgeTaps(double sum, const S *row, const ptrdiff_t *sources, const double *weights,
+                                        size_t taps)
+{
+    for (size_t t = 0; t < taps; t++)
+    {
+        if (sources[t] >= 0)
+        {
+            sum += row[sources[t]] * weights[t];
+        }
+    }
+    return sum;
+}
+
+// Calls fn with the tap count as a compile-time constant for the common
+// kernel widths and with 0 (count known at run time) for any other.
+template <typename Fn>
+static void dispatchTaps(size_t taps, Fn &&fn)
+{
+    switch (taps)
+    {
+    case 3:
+        fn(integral_constant<int, 3>());
+        break;
+    case 5:
+        fn(integral_constant<int, 5>());
+        break;
+    case 7:
+        fn(integral_constant<int, 7>());
+        break;
+    case 9:
+        fn(integral_constant<int, 9>());
+        break;
+    default:
+        fn(integral_constant<int, 0>());
+        break;
+    }
+}
+
+template <typename T>
+static inline T storeSample(double value, OutputRounding rounding)
+{
+    const double largest = static_cast<double>(numeric_limits<T>::max());
+    if (rounding == OutputRounding::NEAREST)
+    {
+        value += 0.5;
+    }
+    if (!(value > 0.0))
+    {
+        return T(0);
+    }
+    return value >= largest ? numeric_limits<T>::max() : static_cast<T>(value);
+}
+
+// Source row for tap row i + t - half of output row i, or nullptr where the
+// border reads zero.
+template <typename S>
+static void tapRows(const ImageView<const S> &image, size_t i, size_t taps, BorderMode border, vector<const S *> &rows)
+{
+    ptrdiff_t half = static_cast<ptrdiff_t>(taps / 2);
+    ptrdiff_t height = static_cast<ptrdiff_t>(image.height());
+    for (size_t t = 0; t < taps; t++)
+    {
+        ptrdiff_t row = borderIndex(static_cast<ptrdiff_t>(i + t) - half, height, border);
+        rows[t] = row >= 0 ? image.row(row) : nullptr;
+    }
+}
+
+static void checkOddLength(size_t length)
+{
+    if (length == 0 || length % 2 == 0)
+    {
+        throw invalid_argument("Kernel sides must be odd");
+    }
+}
+
+template <typename T>
+Image<T> Convolution<T>::convolve2D(const ImageView<const T> &image, const vector<vector<double>> &kernel,
+                                    BorderMode border, OutputRounding rounding, ThreadPool &pool)
+{
+    if (image.empty())
+    {
+        throw invalid_argument("Image is empty");
+    }
+    checkOddLength(kernel.size());
+    size_t kernelRows = kernel.size();
+    size_t kernelCols = kernel[0].size();
+    checkOddLength(kernelCols);
+    vector<double> weights; // row-major
+    weights.reserve(kernelRows * kernelCols);
+    for (const vector<double> &kernelRow : kernel)
+    {
+        if (kernelRow.size() != kernelCols)
+        {
+            throw invalid_argument("Kernel rows must have equal lengths");
+        }
+        weights.insert(weights.end(), kernelRow.begin(), kernelRow.end());
+    }
+
+    size_t width = image.width();
+    size_t height = image.height();
+    size_t halfCols = kernelCols / 2;
+    EdgeColumns edges(width, kernelCols, border);
+    Image<T> output(width, height);
+
+    dispatchTaps(kernelCols, [&](auto tapCount) {
+        constexpr int K = decltype(tapCount)::value;
+        pool.parallelFor(0, height, [&](size_t first, size_t last) {
+            vector<const T *> rows(kernelRows);
+            for (size_t i = first; i < last; i++)
+            {
+                tapRows(image, i, kernelRows, border, rows);
+                T *outRow = output.row(i);
+                auto edgeColumn = [&](size_t j) {
+                    double sum = 0.0;
+                    for (size_t m = 0; m < kernelRows; m++)
+                    {
+                        if (rows[m])
+                        {
+                            sum = accumulateEdgeTaps(sum, rows[m], edges.of(j), weights.data() + m * kernelCols,
+                                                     kernelCols);
+                        }
+                    }
+                    outRow[j] = storeSample<T>(sum, rounding);
+                };
+                for (size_t j = 0; j < edges.interiorBegin; j++)
+                {
+                    edgeColumn(j);
+                }
+                for (size_t j = edges.interiorBegin; j < edges.interiorEnd; j++)
+                {
+                    double sum = 0.0;
+                    for (size_t m = 0; m < kernelRows; m++)
+                    {
+                        if (rows[m])
+                        {
+                            sum = accumulateTaps<K>(sum, rows[m] + j - halfCols, weights.data() + m * kernelCols,
+                                                    kernelCols);
+                        }
+                    }
+                    outRow[j] = storeSample<T>(sum, rounding);
+                }
+                for (size_t j = edges.interiorEnd; j < width; j++)
+                {
+                    edgeColumn(j);
+                }
+            }
+        });
+    });
+    return output;
+}
+
+// Row pass of `horizontal` into `intermediate`, then the column pass of
+// `vertical`; emit(i, sums) receives each finished row of the result.
+template <typename T, typename Emit>
+static void separablePass(const ImageView<const T> &image, const vector<double> &horizontal,
+                          const vector<double> &vertical, BorderMode border, ThreadPool &pool,
+                          Image<double> &intermediate, Emit emit)
+{
+    size_t width = image.width();
+    size_t height = image.height();
+
+    // Horizontal pass into a double intermediate.
+    size_t halfCols = horizontal.size() / 2;
+    EdgeColumns edges(width, horizontal.size(), border);
+    dispatchTaps(horizontal.size(), [&](auto tapCount) {
+        constexpr int K = decltype(tapCount)::value;
+        pool.parallelFor(0, height, [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; i++)
+            {
+                const T *inRow = image.row(i);
+                double *outRow = intermediate.row(i);
+                for (size_t j = 0; j < edges.interiorBegin; j++)
+                {
+                    outRow[j] = accumulateEdgeTaps(0.0, inRow, edges.of(j), horizontal.data(), horizontal.size());
+                }
+                for (size_t j = edges.interiorBegin; j < edges.interiorEnd; j++)
+                {
+                    outRow[j] = accumulateTaps<K>(0.0, inRow + j - halfCols, horizontal.data(), horizontal.size());
+                }
+                for (size_t j = edges.interiorEnd; j < width; j++)
+                {
+                    outRow[j] = accumulateEdgeTaps(0.0, inRow, edges.of(j), horizontal.data(), horizontal.size());
+                }
+            }
+        });
+    });
+
+    // Vertical pass, a whole row at a time: each tap row is added into the
+    // row of sums, so the inner loop runs along contiguous memory and every
+    // sum still adds its taps in order.
+    ImageView<const double> source = intermediate.cview();
+    pool.parallelFor(0, height, [&](size_t first, size_t last) {
+        vector<const double *> rows(vertical.size());
+        vector<double> sums(width);
+        for (size_t i = first; i < last; i++)
+        {
+            tapRows(source, i, vertical.size(), border, rows);
+            fill(sums.begin(), sums.end(), 0.0);
+            for (size_t t = 0; t < vertical.size(); t++)
+            {
+                if (!rows[t])
+                {
+                    continue;
+                }
+                const double *tapRow = rows[t];
+                const double weight = vertical[t];
+                for (size_t j = 0; j < width; j++)
+                {
+                    sums[j] += tapRow[j] * weight;
+                }
+            }
+            emit(i, sums.data());
+        }
+    });
+}
+
+template <typename T>
+Image<T> Convolution<T>::convolveSeparable(const ImageView<const T> &image, const vector<double> &horizontal,
+                                           const vector<double> &vertical, BorderMode border,
+                                           OutputRounding rounding, ThreadPool &pool)
+{
+    if (image.empty())
+    {
+        throw invalid_argument("Image is empty");
+    }
+    checkOddLength(horizontal.size());
+    checkOddLength(vertical.size());
+
+    size_t width = image.width();
+    Image<double> intermediate(width, image.height());
+    Image<T> output(width, image.height());
+    separablePass(image, horizontal, vertical, border, pool, intermediate, [&](size_t i, const double *sums) {
+        T *outRow = output.row(i);
+        for (size_t j = 0; j < width; j++)
+        {
+            outRow[j] = storeSample<T>(sums[j], rounding);
+        }
+    });
+    return output;
+}
+
+template <typename T>
+Image<T> Convolution<T>::convolveTerms(const ImageView<const T> &image, const vector<SeparableTerm> &terms,
+                                       BorderMode border, OutputRounding rounding, ThreadPool &pool)
+{
+    if (image.empty())
+    {
+        throw invalid_argument("Image is empty");
+    }
+    if (terms.empty())
+    {
+        throw invalid_argument("No kernel terms");
+    }
+    for (const SeparableTerm &term : terms)
+    {
+        checkOddLength(term.horizontal.size());
+        checkOddLength(term.vertical.size());
+    }
+    if (terms.size() == 1)
+    {
+        return convolveSeparable(image, terms[0].horizontal, terms[0].vertical, border, rounding, pool);
+    }
+
+    // The terms are summed in double and rounded once, as the last one
+    // finishes each row.
+    size_t width = image.width();
+    Image<double> intermediate(width, image.height());
+    Image<double> total(width, image.height());
+    Image<T> output(width, image.height());
+    for (size_t r = 0; r < terms.size(); r++)
+    {
+        bool last = r + 1 == terms.size();
+        separablePass(image, terms[r].horizontal, terms[r].vertical, border, pool, intermediate,
+                      [&](size_t i, const double *sums) {
+                          double *totalRow = total.row(i);
+                          if (r == 0)
+                          {
+                              copy(sums, sums + width, totalRow);
+                              return;
+                          }
+                          for (size_t j = 0; j < width; j++)
+                          {
+                              totalRow[j] += sums[j];
+                          }
+                          if (last)
+                          {
+                              T *outRow = output.row(i);
+                              for (size_t j = 0; j < width; j++)
+                              {
+                                  outRow[j] = storeSample<T>(totalRow[j], rounding);
+                              }
+                          }
+                      });
+    }
+    return output;
+}
+
+template <typename T>
+Image<T> Convolution<T>::convolve(const ImageView<const T> &image, const vector<vector<double>> &kernel,
+                                  BorderMode border, OutputRounding rounding, double tolerance, ThreadPool &pool)
+{
+    vector<SeparableTerm> terms = separableTerms(kernel);
+    size_t kernelRows = kernel.size();
+    size_t kernelCols = kernel[0].size();
+
+    // Smallest rank whose dropped remainder moves no output by more than
+    // `tolerance` levels: |sum (k - k_r) * v| <= sum |k - k_r| * max(T).
+    vector<double> residual;
+    for (const vector<double> &kernelRow : kernel)
+    {
+        residual.insert(residual.end(), kernelRow.begin(), kernelRow.end());
+    }
+    const double largest = static_cast<double>(numeric_limits<T>::max());
+    size_t rank = 0;
+    double remainder = 0.0;
+    for (double value : residual)
+    {
+        remainder += fabs(value);
+    }
+    while (rank < terms.size() && remainder * largest > tolerance)
+    {
+        const SeparableTerm &term = terms[rank++];
+        remainder = 0.0;
+        for (size_t m = 0; m < kernelRows; m++)
+        {
+            for (size_t n = 0; n < kernelCols; n++)
+            {
+                double &value = residual[m * kernelCols + n];
+                value -= term.vertical[m] * term.horizontal[n];
+                remainder += fabs(value);
+            }
+        }
+    }
+
+    // Multiply-adds per pixel, with two more per separable term for writing
+    // and re-reading its intermediate.
+    size_t directCost = kernelRows * kernelCols;
+    size_t separableCost = max<size_t>(rank, 1) * (kernelRows + kernelCols + 2);
+    if (remainder * largest <= tolerance && separableCost < directCost)
+    {
+        if (rank == 0)
+        {
+            // A kernel of zeros.
+            terms.assign(1, SeparableTerm{vector<double>(kernelCols, 0.0), vector<double>(kernelRows, 0.0)});
+            rank = 1;
+        }
+        terms.resize(rank);
+        return convolveTerms(image, terms, border, rounding, pool);
+    }
+    return convolve2D(image, kernel, border, rounding, pool);
+}
+
+vector<SeparableTerm> separableTerms(const vector<vector<double>> &kernel)
+{
+    checkOddLength(kernel.size());
+    size_t rows = kernel.size();
+    size_t cols = kernel[0].size();
+    checkOddLength(cols);
+
+    // One-sided Jacobi: plane rotations applied to the columns of a (and
+    // accumulated in v) until every pair of columns is orthogonal. Then
+    // k = a v^T, and column j of a and of v give one rank-one term.
+    vector<double> a(rows * cols);
+    for (size_t m = 0; m < rows; m++)
+    {
+        if (kernel[m].size() != cols)
+        {
+            throw invalid_argument("Kernel rows must have equal lengths");
+        }
+        copy(kernel[m].begin(), kernel[m].end(), a.begin() + m * cols);
+    }
+    vector<double> v(cols * cols, 0.0);
+    for (size_t n = 0; n < cols; n++)
+    {
+        v[n * cols + n] = 1.0;
+    }
+    const double epsilon = numeric_limits<double>::epsilon();
+    for (int sweep = 0; sweep < 64; sweep++)
+    {
+        bool rotated = false;
+        for (size_t p = 0; p + 1 < cols; p++)
+        {
+            for (size_t q = p + 1; q < cols; q++)
+            {
+                double alpha = 0.0, beta = 0.0, gamma = 0.0;
+                for (size_t m = 0; m < rows; m++)
+                {
+                    double ap = a[m * cols + p], aq = a[m * cols + q];
+                    alpha += ap * ap;
+                    beta += aq * aq;
+                    gamma += ap * aq;
+                }
+                if (fabs(gamma) <= epsilon * sqrt(alpha * beta))
+                {
+                    continue;
+                }
+                rotated = true;
+                double zeta = (beta - alpha) / (2.0 * gamma);
+                double t = (zeta >= 0 ? 1.0 : -1.0) / (fabs(zeta) + sqrt(1.0 + zeta * zeta));
+                double c = 1.0 / sqrt(1.0 + t * t);
+                double s = c * t;
+                for (size_t m = 0; m < rows; m++)
+                {
+                    double ap = a[m * cols + p], aq = a[m * cols + q];
+                    a[m * cols + p] = c * ap - s * aq;
+                    a[m * cols + q] = s * ap + c * aq;
+                }
+                for (size_t n = 0; n < cols; n++)
+                {
+                    double vp = v[n * cols + p], vq = v[n * cols + q];
+                    v[n * cols + p] = c * vp - s * vq;
+                    v[n * cols + q] = s * vp + c * vq;
+                }
+            }
+        }
+        if (!rotated)
+        {
+            break;
+        }
+    }
+
+    // Column norms of a are the singular values.
+    vector<pair<double, size_t>> order;
+    for (size_t n = 0; n < cols; n++)
+    {
+        double norm = 0.0;
+        for (size_t m = 0; m < rows; m++)
+        {
+            norm += a[m * cols + n] * a[m * cols + n];
+        }
+        if (norm > 0.0)
+        {
+            order.emplace_back(sqrt(norm), n);
+        }
+    }
+    sort(order.begin(), order.end(), [](const pair<double, size_t> &x, const pair<double, size_t> &y) {
+        return x.first > y.first;
+    });
+    // Singular values this far below the largest are rounding noise.
+    double noise = order.empty() ? 0.0 : order[0].first * epsilon * max(rows, cols);
+    vector<SeparableTerm> terms;
+    for (const pair<double, size_t> &singular : order)
+    {
+        if (singular.first <= noise)
+        {
+            break;
+        }
+        SeparableTerm term{vector<double>(cols), vector<double>(rows)};
+        // Split the singular value evenly between the two factors.
+        double scale = sqrt(singular.first);
+        for (size_t m = 0; m < rows; m++)
+        {
+            term.vertical[m] = a[m * cols + singular.second] / scale;
+        }
+        for (size_t n = 0; n < cols; n++)
+        {
+            term.horizontal[n] = v[n * cols + singular.second] * scale;
+        }
+        terms.push_back(move(term));
+    }
+    return terms;
+}
+
+#endif // CONVOLUTION_CPP
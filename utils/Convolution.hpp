@@ -0,0 +1,100 @@
+#ifndef CONVOLUTION_HPP
+#define CONVOLUTION_HPP
+
+#include "Image.hpp"
+#include "ThreadPool.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+// What a kernel tap reads when it falls outside the image, for a row
+// "a b c d":
+//   ZERO       0 0 | a b c d | 0 0
+//   REPLICATE  a a | a b c d | d d
+//   REFLECT    c b | a b c d | c b   (mirrored about the edge sample)
+//   WRAP       c d | a b c d | a b
+enum class BorderMode
+{
+    ZERO,
+    REPLICATE,
+    REFLECT,
+    WRAP
+};
+
+// Sample that stands in for position i of a line of n samples under
+// `border`, or -1 where the border reads zero.
+ptrdiff_t borderIndex(ptrdiff_t i, ptrdiff_t n, BorderMode border);
+
+// How results are stored back into T: truncated toward zero or rounded to
+// nearest. Either way they are clamped to the range of T.
+enum class OutputRounding
+{
+    TRUNCATE,
+    NEAREST
+};
+
+// One rank-one piece of a 2D kernel: k[m][n] = vertical[m] * horizontal[n].
+struct SeparableTerm
+{
+    vector<double> horizontal;
+    vector<double> vertical;
+};
+
+// Singular value decomposition of a kernel with odd sides as rank-one
+// terms, strongest first; singular values at rounding-noise level are
+// dropped. Their sum is the kernel, up to rounding.
+vector<SeparableTerm> separableTerms(const vector<vector<double>> &kernel);
+
+// Direct spatial filtering with any odd-sized kernel:
+// output(y, x) = sum k[m][n] * input(y + m - rows / 2, x + n - cols / 2),
+// the same anchoring as applyGaussianFilter and FFTConvolver.
+//
+// The image is never copied or padded. Each output row reads the source
+// rows its taps land on (remapped by the border mode near the top and
+// bottom), and only the columns within half a kernel of the left and right
+// edges go through per-tap border lookups; the interior runs a plain tap
+// loop. Kernels 3, 5, 7 or 9 taps wide get that loop with a compile-time
+// trip count, which the compiler unrolls. Rows are shared out over `pool`;
+// results do not depend on the thread count.
+template <typename T = uint8_t>
+class Convolution
+{
+public:
+    // `kernel` must be a non-empty rectangle with odd sides.
+    static Image<T> convolve2D(const ImageView<const T> &image, const vector<vector<double>> &kernel,
+                               BorderMode border = BorderMode::ZERO,
+                               OutputRounding rounding = OutputRounding::NEAREST,
+                               ThreadPool &pool = ThreadPool::shared());
+
+    // The rank-one kernel vertical x horizontal as a row pass into a double
+    // intermediate and a column pass; both kernels must have odd lengths.
+    static Image<T> convolveSeparable(const ImageView<const T> &image, const vector<double> &horizontal,
+                                      const vector<double> &vertical, BorderMode border = BorderMode::ZERO,
+                                      OutputRounding rounding = OutputRounding::NEAREST,
+                                      ThreadPool &pool = ThreadPool::shared());
+
+    // Sum of the separable passes of `terms`, accumulated in double and
+    // rounded once.
+    static Image<T> convolveTerms(const ImageView<const T> &image, const vector<SeparableTerm> &terms,
+                                  BorderMode border = BorderMode::ZERO,
+                                  OutputRounding rounding = OutputRounding::NEAREST,
+                                  ThreadPool &pool = ThreadPool::shared());
+
+    // Picks the cheapest exact-enough route for an arbitrary kernel: the
+    // fewest leading terms of separableTerms(kernel) whose dropped remainder
+    // can move no output by more than `tolerance` levels (its absolute sum
+    // times the largest value of T), run as separable passes when that
+    // costs fewer multiply-adds per pixel than convolve2D, and convolve2D
+    // otherwise.
+    static Image<T> convolve(const ImageView<const T> &image, const vector<vector<double>> &kernel,
+                             BorderMode border = BorderMode::ZERO,
+                             OutputRounding rounding = OutputRounding::NEAREST,
+                             double tolerance = DEFAULT_TOLERANCE,
+                             ThreadPool &pool = ThreadPool::shared());
+
+    static constexpr double DEFAULT_TOLERANCE = 0.5;
+};
+
+#endif // CONVOLUTION_HPP
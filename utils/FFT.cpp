@@ -4,6 +4,8 @@
 #include "FFT.hpp"
 #include <cmath>
 #include <cstdint>
+#include <stdexcept>
+#include <algorithm>
 
 template class FFT<uint8_t>;
 template class FFT<uint16_t>;
@@ -14,66 +16,230 @@ template <typename T>
 void FFT<T>::fft(vector<Complex>& x, bool inverse) {
     size_t n = x.size();
     if (n <= 1) return;
+    FFTPlan<>::get(n)->execute(x, inverse);
+}
+
+// Columns per strip in the column pass: 32 values are four cache lines of
+// each plane per image row in double (two in float), and a double strip of
+// a 4096-row image is 2 MB.
+static const size_t COLUMN_BLOCK = 32;
+// Side of the square tiles the transposes are split into: one cache line
+// of doubles, half a line of floats.
+static const size_t TRANSPOSE_TILE = 8;
 
-    size_t j = 0;
-    for (size_t i = 1; i < n; i++) {
-        size_t bit = n >> 1;
-        while (j >= bit) {
-            j -= bit;
-            bit >>= 1;
+// Writes the transpose of the rows x cols block at src (row stride
+// srcStride) to dst (row stride dstStride), tile by tile so that the
+// strided side of the copy touches only TRANSPOSE_TILE cache lines at once.
+template <typename S>
+static void transposeBlocked(const S* src, size_t srcStride, S* dst, size_t dstStride, size_t rows, size_t cols) {
+    for (size_t i0 = 0; i0 < rows; i0 += TRANSPOSE_TILE) {
+        size_t iEnd = min(rows, i0 + TRANSPOSE_TILE);
+        for (size_t j0 = 0; j0 < cols; j0 += TRANSPOSE_TILE) {
+            size_t jEnd = min(cols, j0 + TRANSPOSE_TILE);
+            for (size_t i = i0; i < iEnd; i++) {
+                for (size_t j = j0; j < jEnd; j++) {
+                    dst[j * dstStride + i] = src[i * srcStride + j];
+                }
+            }
         }
-        j += bit;
-        if (i < j) swap(x[i], x[j]);
     }
+}
 
-    for (size_t len = 2; len <= n; len *= 2) {
-        double angle = 2 * M_PI / len * (inverse ? -1 : 1);
-        Complex wn(cos(angle), sin(angle)); 
-        for (size_t i = 0; i < n; i += len) {
-            Complex w(1, 0);
-            for (size_t j = 0; j < len / 2; j++) {
-                Complex t = w * x[i + j + len / 2];
-                Complex u = x[i + j];
-                x[i + j] = u + t;
-                x[i + j + len / 2] = u - t;
-                w = w * wn; 
+// Transforms every column of `image`: each strip of COLUMN_BLOCK columns is
+// transposed into contiguous scratch, transformed there as rows and
+// transposed back. Strips are independent and shared out over `pool`.
+template <typename S>
+static void transformColumns(SplitComplexImage<S>& image, const FFTPlan<S>& colPlan, bool inverse, ThreadPool& pool) {
+    size_t rows = image.rows;
+    size_t cols = image.cols;
+    S* real = image.real.data();
+    S* imag = image.imag.data();
+    size_t stripCount = (cols + COLUMN_BLOCK - 1) / COLUMN_BLOCK;
+    pool.parallelFor(0, stripCount, [&](size_t firstStrip, size_t lastStrip) {
+        // Strip rows are padded by one cache line for the same reason as the
+        // SplitComplexImage stride.
+        size_t stripStride = rows + PIXEL_ALIGNMENT / sizeof(S);
+        vector<S, AlignedAllocator<S>> stripReal(COLUMN_BLOCK * stripStride);
+        vector<S, AlignedAllocator<S>> stripImag(COLUMN_BLOCK * stripStride);
+        for (size_t strip = firstStrip; strip < lastStrip; strip++) {
+            size_t j0 = strip * COLUMN_BLOCK;
+            size_t width = min(COLUMN_BLOCK, cols - j0);
+            transposeBlocked(real + j0, image.stride, stripReal.data(), stripStride, rows, width);
+            transposeBlocked(imag + j0, image.stride, stripImag.data(), stripStride, rows, width);
+            for (size_t c = 0; c < width; c++) {
+                colPlan.execute(stripReal.data() + c * stripStride, stripImag.data() + c * stripStride, inverse);
             }
+            transposeBlocked(stripReal.data(), stripStride, real + j0, image.stride, width, rows);
+            transposeBlocked(stripImag.data(), stripStride, imag + j0, image.stride, width, rows);
+        }
+    });
+}
+
+template <typename S>
+static void splitFFT2D(SplitComplexImage<S>& image, const FFTPlan<S>& rowPlan, const FFTPlan<S>& colPlan,
+                       bool inverse, ThreadPool& pool) {
+    if (rowPlan.size() != image.cols || colPlan.size() != image.rows) {
+        throw invalid_argument("FFT plan sizes do not match image");
+    }
+    pool.parallelFor(0, image.rows, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; i++) {
+            rowPlan.execute(image.realRow(i), image.imagRow(i), inverse);
         }
+    });
+    transformColumns(image, colPlan, inverse, pool);
+}
+
+template <typename S>
+static void realFFT2D(const ImageView<const S>& input, HalfSpectrum<S>& spectrum, ThreadPool& pool) {
+    size_t rows = input.height();
+    size_t cols = input.width();
+    shared_ptr<const RealFFTPlan<S>> rowPlan = RealFFTPlan<S>::get(cols);
+    shared_ptr<const FFTPlan<S>> colPlan = FFTPlan<S>::get(rows);
+
+    spectrum.rows = rows;
+    spectrum.cols = cols;
+    spectrum.spectrumCols = rowPlan->spectrumSize();
+    spectrum.bins.resize(rows, spectrum.spectrumCols);
+
+    pool.parallelFor(0, rows, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; i++) {
+            rowPlan->forward(input.row(i), spectrum.bins.realRow(i), spectrum.bins.imagRow(i));
+        }
+    });
+    // Columns of the half spectrum only: cols / 2 + 1 transforms instead of cols.
+    transformColumns(spectrum.bins, *colPlan, false, pool);
+}
+
+template <typename S>
+static void inverseRealFFT2D(HalfSpectrum<S>& spectrum, const ImageView<S>& output, ThreadPool& pool) {
+    size_t rows = spectrum.rows;
+    size_t cols = spectrum.cols;
+    if (output.height() != rows || output.width() != cols) {
+        throw invalid_argument("Output size does not match spectrum");
     }
-    if (inverse) {
-        for (size_t i = 0; i < n; i++) {
-            x[i] *= (1.0 / n);
+    shared_ptr<const RealFFTPlan<S>> rowPlan = RealFFTPlan<S>::get(cols);
+    shared_ptr<const FFTPlan<S>> colPlan = FFTPlan<S>::get(rows);
+
+    transformColumns(spectrum.bins, *colPlan, true, pool);
+    pool.parallelFor(0, rows, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; i++) {
+            rowPlan->inverse(spectrum.bins.realRow(i), spectrum.bins.imagRow(i), output.row(i));
         }
+    });
+}
+
+template <typename S>
+static void multiplyHalfSpectrum(HalfSpectrum<S>& target, const HalfSpectrum<S>& factor) {
+    if (target.rows != factor.rows || target.cols != factor.cols) {
+        throw invalid_argument("Spectrum sizes do not match");
     }
+    S* tr = target.bins.real.data();
+    S* ti = target.bins.imag.data();
+    const S* fr = factor.bins.real.data();
+    const S* fi = factor.bins.imag.data();
+    // Padding between rows is zero in both and stays zero.
+    size_t count = target.bins.real.size();
+    for (size_t i = 0; i < count; i++) {
+        S re = tr[i] * fr[i] - ti[i] * fi[i];
+        S im = tr[i] * fi[i] + ti[i] * fr[i];
+        tr[i] = re;
+        ti[i] = im;
+    }
+}
+
+template <typename T>
+void FFT<T>::fft2D(SplitComplexImage<double>& image, bool inverse) {
+    fft2D(image, *FFTPlan<double>::get(image.cols), *FFTPlan<double>::get(image.rows), inverse);
+}
+
+template <typename T>
+void FFT<T>::fft2D(SplitComplexImage<float>& image, bool inverse) {
+    fft2D(image, *FFTPlan<float>::get(image.cols), *FFTPlan<float>::get(image.rows), inverse);
+}
+
+template <typename T>
+void FFT<T>::fft2D(SplitComplexImage<double>& image, const FFTPlan<double>& rowPlan, const FFTPlan<double>& colPlan,
+                   bool inverse, ThreadPool& pool) {
+    splitFFT2D(image, rowPlan, colPlan, inverse, pool);
+}
+
+template <typename T>
+void FFT<T>::fft2D(SplitComplexImage<float>& image, const FFTPlan<float>& rowPlan, const FFTPlan<float>& colPlan,
+                   bool inverse, ThreadPool& pool) {
+    splitFFT2D(image, rowPlan, colPlan, inverse, pool);
 }
 
 template <typename T>
 void FFT<T>::fft2D(vector<vector<Complex>>& image, bool inverse) {
-    int rows = image.size();
-    int cols = image[0].size();
-    for (int i = 0; i < rows; i++) {
-        fft(image[i], inverse);
-    }
-    for (int j = 0; j < cols; j++) {
-        vector<Complex> col(rows);
-        for (int i = 0; i < rows; i++) {
-            col[i] = image[i][j];
+    shared_ptr<const FFTPlan<double>> rowPlan = FFTPlan<double>::get(image[0].size());
+    shared_ptr<const FFTPlan<double>> colPlan = FFTPlan<double>::get(image.size());
+    fft2D(image, *rowPlan, *colPlan, inverse);
+}
+
+template <typename T>
+void FFT<T>::fft2D(vector<vector<Complex>>& image, const FFTPlan<double>& rowPlan, const FFTPlan<double>& colPlan,
+                   bool inverse) {
+    size_t rows = image.size();
+    size_t cols = image[0].size();
+    SplitComplexImage<double> split(rows, cols);
+    for (size_t i = 0; i < rows; i++) {
+        double* re = split.realRow(i);
+        double* im = split.imagRow(i);
+        for (size_t j = 0; j < cols; j++) {
+            re[j] = image[i][j].real;
+            im[j] = image[i][j].imag;
         }
-        fft(col, inverse);
-        for (int i = 0; i < rows; i++) {
-            image[i][j] = col[i];
+    }
+    fft2D(split, rowPlan, colPlan, inverse);
+    for (size_t i = 0; i < rows; i++) {
+        const double* re = split.realRow(i);
+        const double* im = split.imagRow(i);
+        for (size_t j = 0; j < cols; j++) {
+            image[i][j] = Complex(re[j], im[j]);
         }
     }
 }
 
 template <typename T>
-vector<vector<T>> FFT<T>::extractOriginalSize(const vector<vector<double>>& paddedResult, int originalRows, int originalCols) {
+void FFT<T>::rfft2D(const ImageView<const double>& input, HalfSpectrum<double>& spectrum, ThreadPool& pool) {
+    realFFT2D(input, spectrum, pool);
+}
+
+template <typename T>
+void FFT<T>::rfft2D(const ImageView<const float>& input, HalfSpectrum<float>& spectrum, ThreadPool& pool) {
+    realFFT2D(input, spectrum, pool);
+}
+
+template <typename T>
+void FFT<T>::irfft2D(HalfSpectrum<double>& spectrum, const ImageView<double>& output, ThreadPool& pool) {
+    inverseRealFFT2D(spectrum, output, pool);
+}
+
+template <typename T>
+void FFT<T>::irfft2D(HalfSpectrum<float>& spectrum, const ImageView<float>& output, ThreadPool& pool) {
+    inverseRealFFT2D(spectrum, output, pool);
+}
+
+template <typename T>
+void FFT<T>::multiplySpectrum(HalfSpectrum<double>& target, const HalfSpectrum<double>& factor) {
+    multiplyHalfSpectrum(target, factor);
+}
+
+template <typename T>
+void FFT<T>::multiplySpectrum(HalfSpectrum<float>& target, const HalfSpectrum<float>& factor) {
+    multiplyHalfSpectrum(target, factor);
+}
+
+template <typename T>
+Image<T> FFT<T>::extractOriginalSize(const ImageView<const double>& paddedResult, int originalRows, int originalCols) {
     
-    vector<vector<T>> result(originalRows, vector<T>(originalCols, 0));
+    Image<T> result(originalCols, originalRows);
     
     for (int i = 0; i < originalRows; i++) {
+        const double* paddedRow = paddedResult.row(i);
+        T* row = result.row(i);
         for (int j = 0; j < originalCols; j++) {
-            result[i][j] = static_cast<T>(round(paddedResult[i][j]));
+            row[j] = static_cast<T>(round(paddedRow[j]));
         }
     }
     
@@ -81,17 +247,19 @@ vector<vector<T>> FFT<T>::extractOriginalSize(const vector<vector<double>>& padd
 }
 
 template <typename T>
-vector<vector<double>> FFT<T>::zeroPad(const vector<vector<double>>& image) {
-    int rows = image.size();
-    int cols = image[0].size();
+Image<double> FFT<T>::zeroPad(const ImageView<const T>& image, int kernelSize) {
+    int rows = image.height();
+    int cols = image.width();
     
-    int paddedRows = pow(2, ceil(log2(rows)));
-    int paddedCols = pow(2, ceil(log2(cols)));
+    int paddedRows = FFTPlan<>::fastSize(rows + kernelSize - 1);
+    int paddedCols = FFTPlan<>::fastSize(cols + kernelSize - 1, true);
     
-    vector<vector<double>> padded(paddedRows, vector<double>(paddedCols, 0.0));
+    Image<double> padded(paddedCols, paddedRows);
     for (int i = 0; i < rows; i++) {
+        const T* row = image.row(i);
+        double* paddedRow = padded.row(i);
         for (int j = 0; j < cols; j++) {
-            padded[i][j] = image[i][j];
+            paddedRow[j] = static_cast<double>(row[j]);
         }
     }
 
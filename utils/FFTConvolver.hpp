@@ -0,0 +1,55 @@
+#ifndef FFT_CONVOLVER_HPP
+#define FFT_CONVOLVER_HPP
+
+#include "FFT.hpp"
+#include "Image.hpp"
+#include "ThreadPool.hpp"
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+// Zero-bordered 2D filtering with an arbitrary kernel through the FFT:
+// output(y, x) = sum k[m][n] * input(y + m - rows / 2, x + n - cols / 2),
+// the same anchoring as applyGaussianFilter.
+//
+// Images are processed with overlap-save: the image is cut into equal
+// tiles whose FFT blocks (tile plus kernel - 1 margin) are at most about
+// tileSize on a side, and each block yields block - kernel + 1 finished
+// output rows and columns. Memory stays bounded by the block size whatever
+// the image size; an image that fits is done in a single block. Kernel
+// spectra are cached process-wide, keyed by the kernel values and the block
+// size, so a kernel is transformed once per block size and then reused by
+// every convolver, tile and image that needs it.
+//
+// 8- and 16-bit images are transformed in float whenever the estimated
+// float rounding error of a block stays below half an output level, which
+// keeps every result within one level of the exact one; anything else, and
+// 32/64-bit images, runs in double.
+template <typename T = uint8_t>
+class FFTConvolver
+{
+public:
+    static const size_t DEFAULT_TILE_SIZE = 1024;
+
+    // `kernel` must be a non-empty rectangle.
+    explicit FFTConvolver(const vector<vector<double>> &kernel, size_t tileSize = DEFAULT_TILE_SIZE,
+                          ThreadPool &pool = ThreadPool::shared());
+
+    // Filtered image, rounded to the nearest value and clamped to T.
+    Image<T> apply(const ImageView<const T> &image) const;
+
+private:
+    template <typename S>
+    Image<T> applyWith(const ImageView<const T> &image, size_t blockRows, size_t blockCols) const;
+
+    vector<double> kernel; // row-major kernelRows x kernelCols
+    double kernelNorm;     // sum of |k|
+    size_t kernelRows;
+    size_t kernelCols;
+    size_t kernelHash;
+    size_t tileSize;
+    ThreadPool *pool;
+};
+
+#endif // FFT_CONVOLVER_HPP
@@ -0,0 +1,584 @@
+#ifndef FFT_PLAN_CPP
+#define FFT_PLAN_CPP
+
+#include "FFTPlan.hpp"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+template class FFTPlan<float>;
+template class FFTPlan<double>;
+template class RealFFTPlan<float>;
+template class RealFFTPlan<double>;
+
+static bool isFiveSmooth(size_t n)
+{
+    for (size_t p : {2, 3, 5})
+    {
+        while (n % p == 0)
+            n /= p;
+    }
+    return n == 1;
+}
+
+template <typename S>
+size_t FFTPlan<S>::fastSize(size_t n, bool even)
+{
+    size_t m = n == 0 ? 1 : n;
+    while (!isFiveSmooth(m) || (even && m % 2 == 1))
+        m++;
+    return m;
+}
+
+template <typename S>
+FFTPlan<S>::FFTPlan(size_t n) : n(n)
+{
+    if (n == 0)
+    {
+        throw invalid_argument("FFT size must be positive");
+    }
+    if (n > UINT32_MAX)
+    {
+        throw invalid_argument("FFT size too large");
+    }
+
+    if (!isFiveSmooth(n))
+    {
+        // Bluestein: X[k] = c[k] * sum_j (x[j] c[j]) conj(c[k - j]), evaluated as
+        // a circular convolution of length M >= 2n - 1.
+        size_t m = fastSize(2 * n - 1);
+        convolutionPlan = FFTPlan::get(m);
+        vector<double> chirpR(n), chirpI(n);
+        for (size_t k = 0; k < n; k++)
+        {
+            // k^2 mod 2n keeps the angle argument small and exact.
+            uint64_t phase = (static_cast<uint64_t>(k) * k) % (2 * static_cast<uint64_t>(n));
+            double angle = M_PI * static_cast<double>(phase) / static_cast<double>(n);
+            chirpR[k] = cos(angle);
+            chirpI[k] = sin(angle);
+        }
+        // The chirp spectrum is always transformed in double, then rounded to S.
+        vector<double> spectrumR(m, 0.0), spectrumI(m, 0.0);
+        spectrumR[0] = chirpR[0];
+        spectrumI[0] = -chirpI[0];
+        for (size_t k = 1; k < n; k++)
+        {
+            spectrumR[k] = spectrumR[m - k] = chirpR[k];
+            spectrumI[k] = spectrumI[m - k] = -chirpI[k];
+        }
+        FFTPlan<double>::get(m)->execute(spectrumR.data(), spectrumI.data(), false);
+        chirpReal.assign(chirpR.begin(), chirpR.end());
+        chirpImag.assign(chirpI.begin(), chirpI.end());
+        chirpSpectrumReal.assign(spectrumR.begin(), spectrumR.end());
+        chirpSpectrumImag.assign(spectrumI.begin(), spectrumI.end());
+        return;
+    }
+
+    size_t remaining = n;
+    vector<uint32_t> radices;
+    for (uint32_t radix : {4u, 2u, 3u, 5u})
+    {
+        while (remaining % radix == 0)
+        {
+            radices.push_back(radix);
+            remaining /= radix;
+        }
+    }
+    // Arrange the factors as a palindrome when possible: the digit reversal is
+    // then its own inverse and can be applied with in-place swaps.
+    vector<uint32_t> front, middle;
+    for (size_t i = 0; i < radices.size(); i++)
+    {
+        if (i + 1 < radices.size() && radices[i + 1] == radices[i])
+        {
+            front.push_back(radices[i]);
+            i++;
+        }
+        else
+        {
+            middle.push_back(radices[i]);
+        }
+    }
+    factors = front;
+    factors.insert(factors.end(), middle.begin(), middle.end());
+    factors.insert(factors.end(), front.rbegin(), front.rend());
+
+    // Input index i = q1 + f1 (q2 + f2 (q3 + ...)) lands at
+    // q1 (n / f1) + q2 (n / (f1 f2)) + ..., so every sub-transform is contiguous.
+    permutation.resize(n);
+    permutationIsInvolution = true;
+    for (size_t i = 0; i < n; i++)
+    {
+        size_t digits = i;
+        size_t span = n;
+        size_t position = 0;
+        for (uint32_t radix : factors)
+        {
+            span /= radix;
+            position += (digits % radix) * span;
+            digits /= radix;
+        }
+        permutation[i] = static_cast<uint32_t>(position);
+    }
+    for (size_t i = 0; i < n; i++)
+    {
+        if (permutation[permutation[i]] != i)
+        {
+            permutationIsInvolution = false;
+            break;
+        }
+    }
+
+    // exp(2*pi*i*q*k / (m * radix)) = exp(2*pi*i*j / n) with j = q*k*step < n.
+    size_t m = 1;
+    for (size_t f = factors.size(); f-- > 0;)
+    {
+        size_t radix = factors[f];
+        size_t step = n / (m * radix);
+        for (size_t q = 1; q < radix; q++)
+        {
+            for (size_t k = 0; k < m; k++)
+            {
+                double angle = 2 * M_PI * static_cast<double>(q * k * step) / static_cast<double>(n);
+                twiddlesReal.push_back(static_cast<S>(cos(angle)));
+                twiddlesImag.push_back(static_cast<S>(sin(angle)));
+            }
+        }
+        m *= radix;
+    }
+}
+
+// Small DFT of `R` inputs (ar, ai) into (br, bi). `s` is +1 for the forward
+// exp(+i...) convention, -1 for inverse.
+template <int R, typename S>
+static inline void butterfly(const S *ar, const S *ai, S *br, S *bi, S s)
+{
+    if constexpr (R == 2)
+    {
+        br[0] = ar[0] + ar[1];
+        bi[0] = ai[0] + ai[1];
+        br[1] = ar[0] - ar[1];
+        bi[1] = ai[0] - ai[1];
+    }
+    else if constexpr (R == 3)
+    {
+        const S sin60 = S(0.86602540378443864676);
+        S tr = ar[1] + ar[2], ti = ai[1] + ai[2];
+        // s * i * sin60 * (a1 - a2)
+        S dr = -s * sin60 * (ai[1] - ai[2]);
+        S di = s * sin60 * (ar[1] - ar[2]);
+        S mr = ar[0] - S(0.5) * tr, mi = ai[0] - S(0.5) * ti;
+        br[0] = ar[0] + tr;
+        bi[0] = ai[0] + ti;
+        br[1] = mr + dr;
+        bi[1] = mi + di;
+        br[2] = mr - dr;
+        bi[2] = mi - di;
+    }
+    else if constexpr (R == 4)
+    {
+        S t0r = ar[0] + ar[2], t0i = ai[0] + ai[2];
+        S t1r = ar[0] - ar[2], t1i = ai[0] - ai[2];
+        S t2r = ar[1] + ar[3], t2i = ai[1] + ai[3];
+        // s * i * (a1 - a3)
+        S t3r = -s * (ai[1] - ai[3]), t3i = s * (ar[1] - ar[3]);
+        br[0] = t0r + t2r;
+        bi[0] = t0i + t2i;
+        br[1] = t1r + t3r;
+        bi[1] = t1i + t3i;
+        br[2] = t0r - t2r;
+        bi[2] = t0i - t2i;
+        br[3] = t1r - t3r;
+        bi[3] = t1i - t3i;
+    }
+    else
+    {
+        static_assert(R == 5, "Unsupported radix");
+        const S c1 = S(0.30901699437494742410), c2 = S(-0.80901699437494742410);
+        const S s1 = S(0.95105651629515357212), s2 = S(0.58778525229247312917);
+        S t1r = ar[1] + ar[4], t1i = ai[1] + ai[4];
+        S t2r = ar[2] + ar[3], t2i = ai[2] + ai[3];
+        S d1r = ar[1] - ar[4], d1i = ai[1] - ai[4];
+        S d2r = ar[2] - ar[3], d2i = ai[2] - ai[3];
+        S m1r = ar[0] + c1 * t1r + c2 * t2r, m1i = ai[0] + c1 * t1i + c2 * t2i;
+        S m2r = ar[0] + c2 * t1r + c1 * t2r, m2i = ai[0] + c2 * t1i + c1 * t2i;
+        // s * i * (s1 d1 + s2 d2) and s * i * (s2 d1 - s1 d2)
+        S e1r = -s * (s1 * d1i + s2 * d2i), e1i = s * (s1 * d1r + s2 * d2r);
+        S e2r = -s * (s2 * d1i - s1 * d2i), e2i = s * (s2 * d1r - s1 * d2r);
+        br[0] = ar[0] + t1r + t2r;
+        bi[0] = ai[0] + t1i + t2i;
+        br[1] = m1r + e1r;
+        bi[1] = m1i + e1i;
+        br[4] = m1r - e1r;
+        bi[4] = m1i - e1i;
+        br[2] = m2r + e2r;
+        bi[2] = m2i + e2i;
+        br[3] = m2r - e2r;
+        bi[3] = m2i - e2i;
+    }
+}
+
+// The R streams k + q * m of one stage never overlap, which the compiler
+// cannot prove for a runtime m; this lets it vectorise the k loop anyway.
+#if defined(__clang__)
+#define FFT_IVDEP _Pragma("clang loop vectorize(assume_safety)")
+#elif defined(__GNUC__)
+#define FFT_IVDEP _Pragma("GCC ivdep")
+#else
+#define FFT_IVDEP
+#endif
+
+// Merges R sub-transforms of length m into transforms of length m * R. The
+// k loop is innermost and both the data and the stage twiddles (twr/twi,
+// (R - 1) runs of m) are read with unit stride, so consecutive butterflies
+// vectorise; float packs twice as many of them per register as double.
+template <int R, typename S>
+static void radixStage(S *re, S *im, size_t n, size_t m, const S *twr, const S *twi, S s)
+{
+    size_t len = m * R;
+    for (size_t block = 0; block < n; block += len)
+    {
+        S *br = re + block;
+        S *bi = im + block;
+        FFT_IVDEP
+        for (size_t k = 0; k < m; k++)
+        {
+            S ar[R], ai[R], cr[R], ci[R];
+            ar[0] = br[k];
+            ai[0] = bi[k];
+            for (int q = 1; q < R; q++)
+            {
+                S vr = br[k + q * m];
+                S vi = bi[k + q * m];
+                S wr = twr[(q - 1) * m + k];
+                S wi = s * twi[(q - 1) * m + k];
+                ar[q] = vr * wr - vi * wi;
+                ai[q] = vr * wi + vi * wr;
+            }
+            butterfly<R>(ar, ai, cr, ci, s);
+            for (int q = 0; q < R; q++)
+            {
+                br[k + q * m] = cr[q];
+                bi[k + q * m] = ci[q];
+            }
+        }
+    }
+}
+
+template <typename S>
+void FFTPlan<S>::execute(S *real, S *imag, bool inverse) const
+{
+    if (n <= 1)
+        return;
+
+    if (convolutionPlan)
+    {
+        // Inverse via conjugation: IDFT(x) = conj(DFT(conj(x))) / n.
+        if (inverse)
+        {
+            for (size_t i = 0; i < n; i++)
+                imag[i] = -imag[i];
+        }
+        executeBluestein(real, imag);
+        if (inverse)
+        {
+            for (size_t i = 0; i < n; i++)
+                imag[i] = -imag[i];
+        }
+    }
+    else
+    {
+        executeMixedRadix(real, imag, inverse);
+    }
+
+    if (inverse)
+    {
+        S scale = S(1) / static_cast<S>(n);
+        for (size_t i = 0; i < n; i++)
+        {
+            real[i] *= scale;
+            imag[i] *= scale;
+        }
+    }
+}
+
+template <typename S>
+void FFTPlan<S>::permute(S *real, S *imag) const
+{
+    if (permutationIsInvolution)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            size_t j = permutation[i];
+            if (i < j)
+            {
+                swap(real[i], real[j]);
+                swap(imag[i], imag[j]);
+            }
+        }
+    }
+    else
+    {
+        static thread_local vector<S> reorderedReal, reorderedImag;
+        reorderedReal.resize(n);
+        reorderedImag.resize(n);
+        for (size_t i = 0; i < n; i++)
+        {
+            reorderedReal[permutation[i]] = real[i];
+            reorderedImag[permutation[i]] = imag[i];
+        }
+        copy(reorderedReal.begin(), reorderedReal.end(), real);
+        copy(reorderedImag.begin(), reorderedImag.end(), imag);
+    }
+}
+
+template <typename S>
+void FFTPlan<S>::executeMixedRadix(S *real, S *imag, bool inverse) const
+{
+    permute(real, imag);
+
+    // Forward uses exp(+2*pi*i/n); the inverse conjugates every twiddle.
+    // Innermost factor first: each stage merges `radix` sub-transforms of
+    // length m into one of length m * radix.
+    const S s = inverse ? S(-1) : S(1);
+    const S *twr = twiddlesReal.data();
+    const S *twi = twiddlesImag.data();
+    size_t m = 1;
+    for (size_t f = factors.size(); f-- > 0;)
+    {
+        size_t radix = factors[f];
+        switch (radix)
+        {
+        case 2:
+            radixStage<2>(real, imag, n, m, twr, twi, s);
+            break;
+        case 3:
+            radixStage<3>(real, imag, n, m, twr, twi, s);
+            break;
+        case 4:
+            radixStage<4>(real, imag, n, m, twr, twi, s);
+            break;
+        case 5:
+            radixStage<5>(real, imag, n, m, twr, twi, s);
+            break;
+        }
+        twr += (radix - 1) * m;
+        twi += (radix - 1) * m;
+        m *= radix;
+    }
+}
+
+template <typename S>
+void FFTPlan<S>::executeBluestein(S *real, S *imag) const
+{
+    size_t m = convolutionPlan->size();
+    static thread_local vector<S> bufferReal, bufferImag;
+    bufferReal.assign(m, S(0));
+    bufferImag.assign(m, S(0));
+    for (size_t k = 0; k < n; k++)
+    {
+        bufferReal[k] = real[k] * chirpReal[k] - imag[k] * chirpImag[k];
+        bufferImag[k] = real[k] * chirpImag[k] + imag[k] * chirpReal[k];
+    }
+    convolutionPlan->execute(bufferReal.data(), bufferImag.data(), false);
+    for (size_t k = 0; k < m; k++)
+    {
+        S br = bufferReal[k];
+        S bi = bufferImag[k];
+        bufferReal[k] = br * chirpSpectrumReal[k] - bi * chirpSpectrumImag[k];
+        bufferImag[k] = br * chirpSpectrumImag[k] + bi * chirpSpectrumReal[k];
+    }
+    convolutionPlan->execute(bufferReal.data(), bufferImag.data(), true);
+    for (size_t k = 0; k < n; k++)
+    {
+        real[k] = bufferReal[k] * chirpReal[k] - bufferImag[k] * chirpImag[k];
+        imag[k] = bufferReal[k] * chirpImag[k] + bufferImag[k] * chirpReal[k];
+    }
+}
+
+template <typename S>
+void FFTPlan<S>::execute(Complex *data, bool inverse) const
+{
+    static thread_local vector<S> stagedReal, stagedImag;
+    stagedReal.resize(n);
+    stagedImag.resize(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        stagedReal[i] = static_cast<S>(data[i].real);
+        stagedImag[i] = static_cast<S>(data[i].imag);
+    }
+    execute(stagedReal.data(), stagedImag.data(), inverse);
+    for (size_t i = 0; i < n; i++)
+    {
+        data[i] = Complex(stagedReal[i], stagedImag[i]);
+    }
+}
+
+template <typename S>
+void FFTPlan<S>::execute(vector<Complex> &data, bool inverse) const
+{
+    if (data.size() != n)
+    {
+        throw invalid_argument("Data length does not match FFT plan size");
+    }
+    execute(data.data(), inverse);
+}
+
+template <typename S>
+shared_ptr<const FFTPlan<S>> FFTPlan<S>::get(size_t n)
+{
+    static mutex cacheMutex;
+    static unordered_map<size_t, shared_ptr<const FFTPlan>> cache;
+
+    {
+        lock_guard<mutex> lock(cacheMutex);
+        auto it = cache.find(n);
+        if (it != cache.end())
+        {
+            return it->second;
+        }
+    }
+    // Built outside the lock: a Bluestein plan fetches its own inner plan.
+    shared_ptr<const FFTPlan> plan = make_shared<FFTPlan>(n);
+    lock_guard<mutex> lock(cacheMutex);
+    return cache.emplace(n, plan).first->second;
+}
+
+template <typename S>
+RealFFTPlan<S>::RealFFTPlan(size_t n) : n(n)
+{
+    if (n == 0)
+    {
+        throw invalid_argument("FFT size must be positive");
+    }
+    if (n % 2 == 1)
+    {
+        complexPlan = FFTPlan<S>::get(n);
+        return;
+    }
+    complexPlan = FFTPlan<S>::get(n / 2);
+    twiddlesReal.resize(n / 2);
+    twiddlesImag.resize(n / 2);
+    for (size_t k = 0; k < n / 2; k++)
+    {
+        double angle = 2 * M_PI * static_cast<double>(k) / static_cast<double>(n);
+        twiddlesReal[k] = static_cast<S>(cos(angle));
+        twiddlesImag[k] = static_cast<S>(sin(angle));
+    }
+}
+
+template <typename S>
+void RealFFTPlan<S>::forward(const S *input, S *outReal, S *outImag) const
+{
+    static thread_local vector<S> scratchReal, scratchImag;
+    if (n % 2 == 1)
+    {
+        scratchReal.assign(input, input + n);
+        scratchImag.assign(n, S(0));
+        complexPlan->execute(scratchReal.data(), scratchImag.data(), false);
+        copy(scratchReal.begin(), scratchReal.begin() + spectrumSize(), outReal);
+        copy(scratchImag.begin(), scratchImag.begin() + spectrumSize(), outImag);
+        return;
+    }
+
+    // z[m] = x[2m] + i x[2m+1]; Z = E + iO where E/O are the even/odd spectra.
+    size_t half = n / 2;
+    scratchReal.resize(half);
+    scratchImag.resize(half);
+    for (size_t m = 0; m < half; m++)
+    {
+        scratchReal[m] = input[2 * m];
+        scratchImag[m] = input[2 * m + 1];
+    }
+    complexPlan->execute(scratchReal.data(), scratchImag.data(), false);
+
+    for (size_t k = 0; k <= half; k++)
+    {
+        S zr = scratchReal[k % half], zi = scratchImag[k % half];
+        // conj(Z[half - k])
+        S cr = scratchReal[(half - k) % half], ci = -scratchImag[(half - k) % half];
+        S er = S(0.5) * (zr + cr);
+        S ei = S(0.5) * (zi + ci);
+        // O = (Z[k] - conj(Z[half - k])) / 2i
+        S orr = S(0.5) * (zi - ci);
+        S oi = S(-0.5) * (zr - cr);
+        S wr = k < half ? twiddlesReal[k] : S(-1);
+        S wi = k < half ? twiddlesImag[k] : S(0);
+        outReal[k] = er + wr * orr - wi * oi;
+        outImag[k] = ei + wr * oi + wi * orr;
+    }
+}
+
+template <typename S>
+void RealFFTPlan<S>::inverse(const S *inReal, const S *inImag, S *output) const
+{
+    static thread_local vector<S> scratchReal, scratchImag;
+    if (n % 2 == 1)
+    {
+        scratchReal.resize(n);
+        scratchImag.resize(n);
+        for (size_t k = 0; k < spectrumSize(); k++)
+        {
+            scratchReal[k] = inReal[k];
+            scratchImag[k] = inImag[k];
+        }
+        for (size_t k = spectrumSize(); k < n; k++)
+        {
+            scratchReal[k] = inReal[n - k];
+            scratchImag[k] = -inImag[n - k];
+        }
+        complexPlan->execute(scratchReal.data(), scratchImag.data(), true);
+        copy(scratchReal.begin(), scratchReal.end(), output);
+        return;
+    }
+
+    size_t half = n / 2;
+    scratchReal.resize(half);
+    scratchImag.resize(half);
+    for (size_t k = 0; k < half; k++)
+    {
+        // a = X[k], b = conj(X[half - k])
+        S ar = inReal[k], ai = inImag[k];
+        S br = inReal[half - k], bi = -inImag[half - k];
+        S er = S(0.5) * (ar + br);
+        S ei = S(0.5) * (ai + bi);
+        // O = (a - b) / 2 * conj(w^k)
+        S dr = S(0.5) * (ar - br);
+        S di = S(0.5) * (ai - bi);
+        S wr = twiddlesReal[k];
+        S wi = -twiddlesImag[k];
+        S orr = dr * wr - di * wi;
+        S oi = dr * wi + di * wr;
+        // Z = E + iO
+        scratchReal[k] = er - oi;
+        scratchImag[k] = ei + orr;
+    }
+    complexPlan->execute(scratchReal.data(), scratchImag.data(), true);
+    for (size_t m = 0; m < half; m++)
+    {
+        output[2 * m] = scratchReal[m];
+        output[2 * m + 1] = scratchImag[m];
+    }
+}
+
+template <typename S>
+shared_ptr<const RealFFTPlan<S>> RealFFTPlan<S>::get(size_t n)
+{
+    static mutex cacheMutex;
+    static unordered_map<size_t, shared_ptr<const RealFFTPlan>> cache;
+
+    lock_guard<mutex> lock(cacheMutex);
+    auto it = cache.find(n);
+    if (it != cache.end())
+    {
+        return it->second;
+    }
+    shared_ptr<const RealFFTPlan> plan = make_shared<RealFFTPlan>(n);
+    cache.emplace(n, plan);
+    return plan;
+}
+
+#endif // FFT_PLAN_CPP
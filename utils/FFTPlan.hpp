@@ -0,0 +1,95 @@
+#ifndef FFT_PLAN_HPP
+#define FFT_PLAN_HPP
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include "Complex.hpp"
+
+using namespace std;
+
+// Precomputed state for a length-n transform of any size, computed in
+// scalar type S (float or double). Sizes whose prime factors are all 2, 3
+// or 5 run as mixed-radix (4/2/3/5) Cooley-Tukey with a precomputed
+// digit-reversal permutation and per-stage twiddles, each evaluated in
+// double with cos/sin before rounding to S. Other sizes use Bluestein's
+// chirp-z algorithm on top of a fast-size plan. The kernels work on split
+// real / imaginary arrays; interleaved Complex data is staged through them.
+// A plan is immutable once built, so one instance can be shared by any
+// number of calls and threads.
+template <typename S = double>
+class FFTPlan
+{
+public:
+    explicit FFTPlan(size_t n);
+
+    size_t size() const { return n; }
+
+    // In-place transform of n reals and n imaginaries. The inverse is
+    // scaled by 1/n.
+    void execute(S *real, S *imag, bool inverse = false) const;
+    // Same on interleaved values, computed in precision S.
+    void execute(Complex *data, bool inverse = false) const;
+    void execute(vector<Complex> &data, bool inverse = false) const;
+
+    // Process-wide cache: returns the shared plan for size n, building it on
+    // first use. Safe to call concurrently.
+    static shared_ptr<const FFTPlan> get(size_t n);
+
+    // Smallest size >= n whose prime factors are only 2, 3 and 5 (and even
+    // when requested, which keeps real transforms on the packed path).
+    static size_t fastSize(size_t n, bool even = false);
+
+private:
+    void permute(S *real, S *imag) const;
+    void executeMixedRadix(S *real, S *imag, bool inverse) const;
+    void executeBluestein(S *real, S *imag) const;
+
+    size_t n;
+    vector<uint32_t> factors;      // outermost split first
+    vector<uint32_t> permutation;  // input index -> digit-reversed position
+    bool permutationIsInvolution = false;
+    // Twiddles, innermost stage first: (radix - 1) runs of m values
+    // exp(2*pi*i*q*k / (m * radix)) per stage, so each stage reads them
+    // contiguously.
+    vector<S> twiddlesReal;
+    vector<S> twiddlesImag;
+
+    // Bluestein state (sizes with a prime factor above 5)
+    shared_ptr<const FFTPlan> convolutionPlan;
+    vector<S> chirpReal;             // exp(pi*i*k^2/n), k < n
+    vector<S> chirpImag;
+    vector<S> chirpSpectrumReal;     // forward transform of the conjugate chirp
+    vector<S> chirpSpectrumImag;
+};
+
+// Plan for real input of length n. For even n the signal is packed into an
+// n/2-point complex transform and split using the n-point twiddles, so only
+// the non-redundant n/2 + 1 output bins are ever computed. Odd n falls back
+// to a full complex transform. Immutable and shareable like FFTPlan.
+template <typename S = double>
+class RealFFTPlan
+{
+public:
+    explicit RealFFTPlan(size_t n);
+
+    size_t size() const { return n; }
+    size_t spectrumSize() const { return n / 2 + 1; }
+
+    // n reals -> n/2 + 1 complex bins, written as split real / imaginary
+    // arrays.
+    void forward(const S *input, S *outReal, S *outImag) const;
+    // n/2 + 1 split complex bins -> n reals, scaled by 1/n.
+    void inverse(const S *inReal, const S *inImag, S *output) const;
+
+    static shared_ptr<const RealFFTPlan> get(size_t n);
+
+private:
+    size_t n;
+    shared_ptr<const FFTPlan<S>> complexPlan;
+    vector<S> twiddlesReal; // exp(2*pi*i*k/n), k < n/2 (even n only)
+    vector<S> twiddlesImag;
+};
+
+#endif // FFT_PLAN_HPP
@@ -2,58 +2,190 @@
 #define IMAGE_READER_CPP
 
 #include "ImageReader.hpp"
-#include <fstream>
-#include <sstream>
+#include <algorithm>
+#include <cstdint>
 
 template class ImageReader<uint8_t>;
 template class ImageReader<uint16_t>;
 template class ImageReader<uint32_t>;
 template class ImageReader<uint64_t>;
 
+template void decodePGMRows<uint8_t>(const uint8_t *, uint32_t, const ImageView<uint8_t> &);
+template void decodePGMRows<uint16_t>(const uint8_t *, uint32_t, const ImageView<uint16_t> &);
+template void decodePGMRows<uint32_t>(const uint8_t *, uint32_t, const ImageView<uint32_t> &);
+template void decodePGMRows<uint64_t>(const uint8_t *, uint32_t, const ImageView<uint64_t> &);
+
 template <typename T>
 ImageReader<T>::ImageReader() {}
 
-template <typename T>
-ImageStatus ImageReader<T>::readImage(const string &filePath, Image<T> &image)
+static bool isPNMWhitespace(uint8_t c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+// Skips whitespace and '#' comments, then reads one unsigned decimal field.
+static bool readPNMField(const uint8_t *data, size_t size, size_t &pos, uint32_t &value)
 {
-    ifstream file(filePath, ios::binary);
-    if (!file.is_open())
+    while (pos < size)
+    {
+        if (isPNMWhitespace(data[pos]))
+        {
+            ++pos;
+        }
+        else if (data[pos] == '#')
+        {
+            while (pos < size && data[pos] != '\n' && data[pos] != '\r')
+                ++pos;
+        }
+        else
+        {
+            break;
+        }
+    }
+    if (pos >= size || data[pos] < '0' || data[pos] > '9')
     {
-        return ImageStatus::FILE_NOT_FOUND;
+        return false;
     }
+    uint64_t result = 0;
+    while (pos < size && data[pos] >= '0' && data[pos] <= '9')
+    {
+        result = result * 10 + (data[pos] - '0');
+        if (result > UINT32_MAX)
+        {
+            return false;
+        }
+        ++pos;
+    }
+    value = static_cast<uint32_t>(result);
+    return true;
+}
 
-    vector<T> rawData((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
-    file.close();
+ImageStatus parsePNMHeader(const uint8_t *data, size_t size, ImageMetadata &metadata, size_t &headerSize)
+{
+    if (size < 2 || data[0] != 'P')
+    {
+        return ImageStatus::PARSE_ERROR;
+    }
+    if (data[1] == '2')
+    {
+        return ImageStatus::UNIMPLEMENTED_FEATURE;
+    }
+    bool bitmap = data[1] == '4';
+    if ((data[1] != '5' && !bitmap) || size < 3 || !isPNMWhitespace(data[2]))
+    {
+        return ImageStatus::PARSE_ERROR;
+    }
 
-    if (rawData.empty())
+    // A bitmap header has no maxval field.
+    size_t pos = 2;
+    uint32_t width = 0, height = 0, maxValue = 1;
+    if (!readPNMField(data, size, pos, width) ||
+        !readPNMField(data, size, pos, height) ||
+        (!bitmap && !readPNMField(data, size, pos, maxValue)))
     {
-        return ImageStatus::FILE_READ_ERROR;
+        return ImageStatus::PARSE_ERROR;
+    }
+    // Exactly one whitespace byte separates the last field from the raster.
+    if (width == 0 || height == 0 || maxValue == 0 || pos >= size || !isPNMWhitespace(data[pos]))
+    {
+        return ImageStatus::PARSE_ERROR;
     }
 
-    image.metadata.format = detectFormat(rawData);
+    metadata.format = bitmap ? ImageFormat::PBM : ImageFormat::PGM;
+    metadata.width = width;
+    metadata.height = height;
+    metadata.maxValue = maxValue;
+    metadata.channels = 1;
+    headerSize = pos + 1;
+    return ImageStatus::SUCCESS;
+}
+
+template <typename T>
+ImageStatus ImageReader<T>::readImage(const string &filePath, Image<T> &image)
+{
+    MappedFile file;
+    ImageStatus status = file.open(filePath);
+    if (status != ImageStatus::SUCCESS)
+    {
+        return status;
+    }
+
+    image.metadata.format = detectFormat(file.data(), file.size());
     switch (image.metadata.format)
     {
     case ImageFormat::PGM:
-        return parsePGM(rawData, image);
+        return parsePGM(file.data(), file.size(), image);
     case ImageFormat::PNG:
-        return parsePNG(rawData, image);
+        return parsePNG(file.data(), file.size(), image);
     case ImageFormat::JPEG:
-        return parseJPEG(rawData, image);
+        return parseJPEG(file.data(), file.size(), image);
     case ImageFormat::BMP:
-        return parseBMP(rawData, image);
+        return parseBMP(file.data(), file.size(), image);
+    case ImageFormat::PBM: // Bitmaps load into a BinaryImage through readPBM.
     default:
         return ImageStatus::UNSUPPORTED_FORMAT;
     }
 }
 
 template <typename T>
-ImageFormat ImageReader<T>::detectFormat(const vector<T> &rawData)
+ImageStatus ImageReader<T>::readImageMapped(const string &filePath, MappedImage<T> &image)
+{
+    MappedFile file;
+    ImageStatus status = file.open(filePath);
+    if (status != ImageStatus::SUCCESS)
+    {
+        return status;
+    }
+    if (detectFormat(file.data(), file.size()) != ImageFormat::PGM)
+    {
+        return ImageStatus::UNSUPPORTED_FORMAT;
+    }
+
+    ImageMetadata metadata;
+    size_t headerSize = 0;
+    status = parsePNMHeader(file.data(), file.size(), metadata, headerSize);
+    if (status != ImageStatus::SUCCESS)
+    {
+        return status;
+    }
+    status = checkPGMPayload(metadata, headerSize, file.size());
+    if (status != ImageStatus::SUCCESS)
+    {
+        return status;
+    }
+
+    image.imageMetadata = metadata;
+    image.decoded.clear();
+    if (sizeof(T) == 1 && metadata.maxValue <= 255)
+    {
+        // Zero copy: the mapped raster already has the in-memory layout.
+        const T *pixels = reinterpret_cast<const T *>(file.data() + headerSize);
+        image.pixels = ImageView<const T>(pixels, metadata.width, metadata.height, metadata.width);
+        image.file = move(file);
+    }
+    else
+    {
+        image.decoded.allocate(metadata.width, metadata.height);
+        image.decoded.metadata = metadata;
+        decodePGMRows(file.data() + headerSize, metadata.maxValue, image.decoded.view());
+        image.pixels = image.decoded.cview();
+        image.file.close();
+    }
+    return ImageStatus::SUCCESS;
+}
+
+template <typename T>
+ImageFormat ImageReader<T>::detectFormat(const uint8_t *rawData, size_t size)
 {
-    if (rawData.size() >= 2 && rawData[0] == 'P' && rawData[1] == '5')
+    if (size >= 2 && rawData[0] == 'P' && rawData[1] == '5')
     {
         return ImageFormat::PGM;
     }
-    else if (rawData.size() >= 8 &&
+    else if (size >= 2 && rawData[0] == 'P' && rawData[1] == '4')
+    {
+        return ImageFormat::PBM;
+    }
+    else if (size >= 8 &&
              rawData[0] == 0x89 && rawData[1] == 'P' && rawData[2] == 'N' &&
              rawData[3] == 'G' && rawData[4] == 0x0D &&
              rawData[5] == 0x0A && rawData[6] == 0x1A &&
@@ -61,11 +193,11 @@ ImageFormat ImageReader<T>::detectFormat(const vector<T> &rawData)
     {
         return ImageFormat::PNG;
     }
-    else if (rawData.size() >= 2 && rawData[0] == 0xFF && rawData[1] == 0xD8)
+    else if (size >= 2 && rawData[0] == 0xFF && rawData[1] == 0xD8)
     {
         return ImageFormat::JPEG;
     }
-    else if (rawData.size() >= 2 && rawData[0] == 'B' && rawData[1] == 'M')
+    else if (size >= 2 && rawData[0] == 'B' && rawData[1] == 'M')
     {
         return ImageFormat::BMP;
     }
@@ -73,126 +205,154 @@ ImageFormat ImageReader<T>::detectFormat(const vector<T> &rawData)
 }
 
 template <typename T>
-ImageStatus ImageReader<T>::parseMetadata(const vector<T> &, ImageMetadata &)
+ImageStatus ImageReader<T>::parseMetadata(const uint8_t *, size_t, ImageMetadata &)
 {
     return ImageStatus::UNIMPLEMENTED_FEATURE; // Reserved for shared metadata logic if needed.
 }
 
 template <typename T>
-ImageStatus ImageReader<T>::parsePGM(const vector<T> &rawData, Image<T> &image)
+ImageStatus ImageReader<T>::checkPGMPayload(const ImageMetadata &metadata, size_t headerSize, size_t size)
 {
-    istringstream stream(string(rawData.begin(), rawData.end()));
-    string line;
-    string magicNumber;
-    uint32_t width = 0, height = 0, maxValue = 0;
-
-    // Read magic number
-    getline(stream, line);
-    if (line == "P2")
+    size_t bytesPerSample;
+    if (metadata.maxValue <= 255)
     {
-        return ImageStatus::UNIMPLEMENTED_FEATURE;
+        bytesPerSample = 1;
     }
-    else if (line != "P5")
+    else if (metadata.maxValue <= 65535)
     {
-        return ImageStatus::PARSE_ERROR;
+        if (sizeof(T) < 2)
+        {
+            return ImageStatus::INVALID_DATASIZE;
+        }
+        bytesPerSample = 2;
     }
-    magicNumber = line;
-
-    // Read width, height, and maxValue while skipping comments
-    while (getline(stream, line))
+    else
     {
-        if (line.empty() || line[0] == '#')
-            continue;
-        istringstream dimensions(line);
-        dimensions >> width >> height;
-        if (width > 0 && height > 0)
-            break;
+        return ImageStatus::UNSUPPORTED_FORMAT;
     }
-    while (getline(stream, line))
+
+    size_t pixelCount = static_cast<size_t>(metadata.width) * metadata.height;
+    if (size - headerSize < pixelCount * bytesPerSample)
     {
-        if (line.empty() || line[0] == '#')
-            continue;
-        istringstream maxValStream(line);
-        maxValStream >> maxValue;
-        if (maxValue > 0)
-            break;
+        return ImageStatus::FILE_READ_ERROR;
     }
+    return ImageStatus::SUCCESS;
+}
 
-    if (width == 0 || height == 0 || maxValue == 0)
+template <typename T>
+void decodePGMRows(const uint8_t *pixelBytes, uint32_t maxValue, const ImageView<T> &dst)
+{
+    uint32_t width = dst.width();
+    if (maxValue <= 255)
     {
-        return ImageStatus::PARSE_ERROR;
+        for (uint32_t i = 0; i < dst.height(); ++i)
+        {
+            const uint8_t *src = pixelBytes + static_cast<size_t>(i) * width;
+            copy(src, src + width, dst.row(i));
+        }
+        return;
     }
 
-    image.metadata.width = width;
-    image.metadata.height = height;
-    image.metadata.maxValue = maxValue;
-
-    // Get position of pixel data after header
-    size_t headerSize = stream.tellg();
-    if (headerSize == -1)
+    // Big-endian 16-bit samples: a branch-free byte-swap loop the compiler
+    // vectorizes (one pass over the raster).
+    for (uint32_t i = 0; i < dst.height(); ++i)
     {
-        return ImageStatus::PARSE_ERROR;
+        const uint8_t *src = pixelBytes + 2 * static_cast<size_t>(i) * width;
+        T *row = dst.row(i);
+        for (uint32_t j = 0; j < width; ++j)
+        {
+            row[j] = static_cast<T>((static_cast<uint16_t>(src[2 * j]) << 8) | src[2 * j + 1]);
+        }
     }
+}
 
-    if (rawData.size() < headerSize + width * height)
+template <typename T>
+ImageStatus ImageReader<T>::parsePGM(const uint8_t *rawData, size_t size, Image<T> &image)
+{
+    ImageMetadata metadata;
+    size_t headerSize = 0;
+    ImageStatus status = parsePNMHeader(rawData, size, metadata, headerSize);
+    if (status != ImageStatus::SUCCESS)
     {
-        return ImageStatus::FILE_READ_ERROR;
+        return status;
+    }
+    status = checkPGMPayload(metadata, headerSize, size);
+    if (status != ImageStatus::SUCCESS)
+    {
+        return status;
     }
 
-    // Fill pixelData
-    if (maxValue <= 255)
+    image.allocate(metadata.width, metadata.height);
+    image.metadata = metadata;
+    decodePGMRows(rawData + headerSize, metadata.maxValue, image.view());
+    return ImageStatus::SUCCESS;
+}
+
+ImageStatus readPBM(const string &filePath, BinaryImage &image)
+{
+    MappedFile file;
+    ImageStatus status = file.open(filePath);
+    if (status != ImageStatus::SUCCESS)
     {
-        if (sizeof (T) < 1)
-        {
-            return ImageStatus::INVALID_DATASIZE;
-        }
-        image.pixelData.assign(rawData.begin() + headerSize, rawData.begin() + headerSize + width * height);
+        return status;
     }
-    else if (maxValue <= 65535)
+    ImageMetadata metadata;
+    size_t headerSize = 0;
+    status = parsePNMHeader(file.data(), file.size(), metadata, headerSize);
+    if (status != ImageStatus::SUCCESS)
     {
-        if (sizeof (T) < 2)
-        {
-            return ImageStatus::INVALID_DATASIZE;
-        }
-        image.pixelData.resize(width * height);
-        for (uint32_t i = 0; i < width * height; ++i)
-        {
-            image.pixelData[i] = (rawData[headerSize + 2 * i] << 8) | rawData[headerSize + 2 * i + 1];
-        }
+        return status;
     }
-    else
+    if (metadata.format != ImageFormat::PBM)
     {
         return ImageStatus::UNSUPPORTED_FORMAT;
     }
+    size_t rowBytes = (static_cast<size_t>(metadata.width) + 7) / 8;
+    if (file.size() - headerSize < rowBytes * metadata.height)
+    {
+        return ImageStatus::FILE_READ_ERROR;
+    }
 
-    // Fill pixelMatrix
-    image.pixelMatrix.resize(height, vector<T>(width));
-    for (uint32_t i = 0; i < height; ++i)
+    // Raster rows are packed most significant bit first, which is the
+    // mask's bit order: each word is eight raster bytes read big-endian.
+    image.allocate(metadata.width, metadata.height);
+    uint64_t tail = image.lastWordMask();
+    for (uint32_t y = 0; y < metadata.height; y++)
     {
-        for (uint32_t j = 0; j < width; ++j)
+        const uint8_t *src = file.data() + headerSize + y * rowBytes;
+        uint64_t *row = image.row(y);
+        for (size_t i = 0; i < image.wordsPerRow(); i++)
         {
-            image.pixelMatrix[i][j] = image.pixelData[i * width + j];
+            size_t begin = i * 8;
+            size_t count = min<size_t>(8, rowBytes - begin);
+            uint64_t word = 0;
+            for (size_t b = 0; b < count; b++)
+            {
+                word |= static_cast<uint64_t>(src[begin + b]) << (56 - 8 * b);
+            }
+            row[i] = word;
         }
+        // Padding bits at the end of a raster row may hold anything.
+        row[image.wordsPerRow() - 1] &= tail;
     }
-
     return ImageStatus::SUCCESS;
 }
 
 // Placeholder implementations for future formats
 template <typename T>
-ImageStatus ImageReader<T>::parsePNG(const vector<T> &, Image<T> &)
+ImageStatus ImageReader<T>::parsePNG(const uint8_t *, size_t, Image<T> &)
 {
     return ImageStatus::UNIMPLEMENTED_FEATURE; // Implement later
 }
 
 template <typename T>
-ImageStatus ImageReader<T>::parseJPEG(const vector<T> &, Image<T> &)
+ImageStatus ImageReader<T>::parseJPEG(const uint8_t *, size_t, Image<T> &)
 {
     return ImageStatus::UNIMPLEMENTED_FEATURE; // Implement later
 }
 
 template <typename T>
-ImageStatus ImageReader<T>::parseBMP(const vector<T> &, Image<T> &)
+ImageStatus ImageReader<T>::parseBMP(const uint8_t *, size_t, Image<T> &)
 {
     return ImageStatus::UNIMPLEMENTED_FEATURE; // Implement later
 }
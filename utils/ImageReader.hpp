@@ -2,9 +2,26 @@
 #define IMAGE_READER_HPP
 
 #include "Image.hpp"
+#include "MappedImage.hpp"
+#include "BinaryImage.hpp"
 #include <vector>
 using namespace std;
 
+// Parses a binary netpbm header (magic, width, height, maxval and comments)
+// directly from raw bytes. On success `headerSize` is the offset of the
+// first pixel byte. P4 bitmaps have no maxval; they report format PBM with
+// maxValue 1.
+ImageStatus parsePNMHeader(const uint8_t *data, size_t size, ImageMetadata &metadata, size_t &headerSize);
+
+// Decodes dst.height() packed raster rows of dst.width() PGM samples
+// (8-bit, or big-endian 16-bit when maxValue > 255) into `dst`.
+template <typename T = uint8_t>
+void decodePGMRows(const uint8_t *pixelBytes, uint32_t maxValue, const ImageView<T> &dst);
+
+// Reads a PBM (P4) bitmap into a packed mask; set bits are the black
+// pixels.
+ImageStatus readPBM(const string &filePath, BinaryImage &image);
+
 template <typename T = uint8_t>
 class ImageReader
 {
@@ -13,15 +30,22 @@ public:
 
     ImageStatus readImage(const string &filePath, Image<T> &image);
 
+    // Memory-mapped read: 8-bit data read as uint8_t is exposed in place,
+    // wider data is decoded in a single pass. PGM (P5) only.
+    ImageStatus readImageMapped(const string &filePath, MappedImage<T> &image);
+
 private:
-    ImageFormat detectFormat(const vector<T> &rawData);
+    ImageFormat detectFormat(const uint8_t *data, size_t size);
+
+    ImageStatus parseMetadata(const uint8_t *data, size_t size, ImageMetadata &metadata);
 
-    ImageStatus parseMetadata(const vector<T> &rawData, ImageMetadata &metadata);
+    ImageStatus parsePGM(const uint8_t *data, size_t size, Image<T> &image);
+    ImageStatus parsePNG(const uint8_t *data, size_t size, Image<T> &image);
+    ImageStatus parseJPEG(const uint8_t *data, size_t size, Image<T> &image);
+    ImageStatus parseBMP(const uint8_t *data, size_t size, Image<T> &image);
 
-    ImageStatus parsePGM(const vector<T> &rawData, Image<T> &image);
-    ImageStatus parsePNG(const vector<T> &rawData, Image<T> &image);
-    ImageStatus parseJPEG(const vector<T> &rawData, Image<T> &image);
-    ImageStatus parseBMP(const vector<T> &rawData, Image<T> &image);
+    // Validates sample width against T and the available bytes.
+    ImageStatus checkPGMPayload(const ImageMetadata &metadata, size_t headerSize, size_t size);
 };
 
 #endif // IMAGE_READER_HPP
@@ -3,35 +3,165 @@
 
 #include "ImageWriter.hpp"
 #include <fstream>
+#include <vector>
 
 template class ImageWriter<uint8_t>;
 template class ImageWriter<uint16_t>;
 template class ImageWriter<uint32_t>;
 template class ImageWriter<uint64_t>;
 
+template void encodePGMRow<uint8_t>(const uint8_t *, uint32_t, uint32_t, vector<uint8_t> &);
+template void encodePGMRow<uint16_t>(const uint16_t *, uint32_t, uint32_t, vector<uint8_t> &);
+template void encodePGMRow<uint32_t>(const uint32_t *, uint32_t, uint32_t, vector<uint8_t> &);
+template void encodePGMRow<uint64_t>(const uint64_t *, uint32_t, uint32_t, vector<uint8_t> &);
+
+template <typename T>
+void encodePGMRow(const T *row, uint32_t width, uint32_t maxValue, vector<uint8_t> &bytes)
+{
+    if (maxValue <= 255)
+    {
+        bytes.resize(width);
+        for (uint32_t j = 0; j < width; ++j)
+        {
+            bytes[j] = static_cast<uint8_t>(row[j]);
+        }
+        return;
+    }
+
+    // PGM stores 16-bit samples most significant byte first.
+    bytes.resize(2 * static_cast<size_t>(width));
+    for (uint32_t j = 0; j < width; ++j)
+    {
+        bytes[2 * j] = static_cast<uint8_t>(row[j] >> 8);
+        bytes[2 * j + 1] = static_cast<uint8_t>(row[j]);
+    }
+}
+
+ImageStatus writePBM(const string &filePath, const BinaryImage &image)
+{
+    if (image.empty())
+    {
+        return ImageStatus::INVALID_DIMENSIONS;
+    }
+    ofstream file(filePath, ios::binary);
+    if (!file.is_open())
+    {
+        return ImageStatus::FILE_WRITE_ERROR;
+    }
+
+    file << "P4\n";
+    file << image.width() << " " << image.height() << "\n";
+
+    // Each word, most significant byte first, is the next eight raster
+    // bytes; the row's last word is cut to the bytes the width needs.
+    size_t rowBytes = (static_cast<size_t>(image.width()) + 7) / 8;
+    vector<uint8_t> bytes(image.wordsPerRow() * 8);
+    for (uint32_t y = 0; y < image.height(); ++y)
+    {
+        const uint64_t *row = image.row(y);
+        for (size_t i = 0; i < image.wordsPerRow(); ++i)
+        {
+            for (size_t b = 0; b < 8; ++b)
+            {
+                bytes[i * 8 + b] = static_cast<uint8_t>(row[i] >> (56 - 8 * b));
+            }
+        }
+        file.write(reinterpret_cast<const char *>(bytes.data()), rowBytes);
+    }
+
+    file.close();
+    if (!file)
+    {
+        return ImageStatus::FILE_WRITE_ERROR;
+    }
+    return ImageStatus::SUCCESS;
+}
+
 template <typename T>
 ImageWriter<T>::ImageWriter() {}
 
 template <typename T>
 ImageStatus ImageWriter<T>::writeImage(const string &filePath, const Image<T> &image)
 {
-    switch (image.metadata.format)
+    if (!image.empty() && !image.orientation().isIdentity())
     {
-    case ImageFormat::PGM:
+        // Only the PGM encoder gathers from the stored pixels; the others
+        // take views, which a const image with a pending orientation has not.
+        if (image.metadata.format != ImageFormat::PGM)
+        {
+            return ImageStatus::UNIMPLEMENTED_FEATURE;
+        }
         return writePGM(filePath, image);
+    }
+    return writeImage(filePath, image.cview(), image.metadata);
+}
+
+template <typename T>
+ImageStatus ImageWriter<T>::writeImage(const string &filePath, const ImageView<const T> &view, const ImageMetadata &metadata)
+{
+    if (view.empty())
+    {
+        return ImageStatus::INVALID_DIMENSIONS;
+    }
+    switch (metadata.format)
+    {
+    case ImageFormat::PGM:
+        return writePGM(filePath, view, metadata);
     case ImageFormat::PNG:
-        return writePNG(filePath, image);
+        return writePNG(filePath, view, metadata);
     case ImageFormat::JPEG:
-        return writeJPEG(filePath, image);
+        return writeJPEG(filePath, view, metadata);
     case ImageFormat::BMP:
-        return writeBMP(filePath, image);
+        return writeBMP(filePath, view, metadata);
     default:
         return ImageStatus::UNSUPPORTED_FORMAT;
     }
 }
 
+template <typename T>
+ImageStatus ImageWriter<T>::writePGM(const string &filePath, const ImageView<const T> &view, const ImageMetadata &metadata)
+{
+    if (view.channels() != 1)
+    {
+        return ImageStatus::INVALID_CHANNELS;
+    }
+    return writePGMRows(filePath, view.width(), view.height(), metadata.maxValue,
+                        [&](uint32_t i, vector<T> &) { return view.row(i); });
+}
+
 template <typename T>
 ImageStatus ImageWriter<T>::writePGM(const string &filePath, const Image<T> &image)
+{
+    if (image.metadata.channels != 1)
+    {
+        return ImageStatus::INVALID_CHANNELS;
+    }
+    // Each output row is a straight line through the stored pixels: along
+    // a stored row (possibly backwards) or down a stored column.
+    const T *stored = image.storedView().data();
+    OrientedLayout layout = image.orientedLayout();
+    uint32_t width = image.metadata.width;
+    return writePGMRows(filePath, width, image.metadata.height, image.metadata.maxValue,
+                        [&](uint32_t i, vector<T> &scratch)
+                        {
+                            const T *in = stored + layout.origin + static_cast<ptrdiff_t>(i) * layout.rowStep;
+                            if (layout.pixelStep == 1)
+                            {
+                                return in;
+                            }
+                            scratch.resize(width);
+                            for (uint32_t j = 0; j < width; ++j)
+                            {
+                                scratch[j] = in[static_cast<ptrdiff_t>(j) * layout.pixelStep];
+                            }
+                            return static_cast<const T *>(scratch.data());
+                        });
+}
+
+template <typename T>
+template <typename RowSource>
+ImageStatus ImageWriter<T>::writePGMRows(const string &filePath, uint32_t width, uint32_t height, uint32_t maxValue,
+                                         RowSource rowAt)
 {
     ofstream file(filePath, ios::binary);
     if (!file.is_open())
@@ -41,26 +171,22 @@ ImageStatus ImageWriter<T>::writePGM(const string &filePath, const Image<T> &ima
 
     // Write PGM header
     file << "P5\n";
-    file << image.metadata.width << " " << image.metadata.height << "\n";
-    file << image.metadata.maxValue << "\n";
+    file << width << " " << height << "\n";
+    file << maxValue << "\n";
 
-    // Write pixel data from pixelMatrix
-    if (image.metadata.maxValue <= 255)
-    {
-        for (const auto &row : image.pixelMatrix)
-        {
-            file.write(reinterpret_cast<const char *>(row.data()), row.size());
-        }
-    }
-    else
+    // Write pixel data row by row
+    vector<T> scratch;
+    vector<uint8_t> rowBytes;
+    for (uint32_t i = 0; i < height; ++i)
     {
-        for (const auto &row : image.pixelMatrix)
+        const T *row = rowAt(i, scratch);
+        if (sizeof(T) == 1)
         {
-            for (const auto &pixel : row)
-            {
-                file.write(reinterpret_cast<const char *>(&pixel), sizeof(T));
-            }
+            file.write(reinterpret_cast<const char *>(row), width);
+            continue;
         }
+        encodePGMRow(row, width, maxValue, rowBytes);
+        file.write(reinterpret_cast<const char *>(rowBytes.data()), rowBytes.size());
     }
 
     file.close();
@@ -73,19 +199,19 @@ ImageStatus ImageWriter<T>::writePGM(const string &filePath, const Image<T> &ima
 }
 
 template <typename T>
-ImageStatus ImageWriter<T>::writePNG(const string &, const Image<T> &)
+ImageStatus ImageWriter<T>::writePNG(const string &, const ImageView<const T> &, const ImageMetadata &)
 {
     return ImageStatus::UNIMPLEMENTED_FEATURE; // To be implemented later
 }
 
 template <typename T>
-ImageStatus ImageWriter<T>::writeJPEG(const string &, const Image<T> &)
+ImageStatus ImageWriter<T>::writeJPEG(const string &, const ImageView<const T> &, const ImageMetadata &)
 {
     return ImageStatus::UNIMPLEMENTED_FEATURE; // To be implemented later
 }
 
 template <typename T>
-ImageStatus ImageWriter<T>::writeBMP(const string &, const Image<T> &)
+ImageStatus ImageWriter<T>::writeBMP(const string &, const ImageView<const T> &, const ImageMetadata &)
 {
     return ImageStatus::UNIMPLEMENTED_FEATURE; // To be implemented later
 }
@@ -2,22 +2,45 @@
 #define IMAGE_WRITER_HPP
 
 #include "Image.hpp"
+#include "BinaryImage.hpp"
 #include <string>
+#include <vector>
 using namespace std;
 
+// Encodes one row of `width` samples as PGM raster bytes (8-bit, or
+// big-endian 16-bit when maxValue > 255) into `bytes`, resizing it.
+template <typename T = uint8_t>
+void encodePGMRow(const T *row, uint32_t width, uint32_t maxValue, vector<uint8_t> &bytes);
+
+// Writes a packed mask as a PBM (P4) bitmap, one raster byte per eight
+// pixels; set bits come out black.
+ImageStatus writePBM(const string &filePath, const BinaryImage &image);
+
 template <typename T = uint8_t>
 class ImageWriter
 {
 public:
     ImageWriter();
 
+    // An image with a pending orientation (Image::reorient) is written as
+    // reoriented; PGM rows are gathered straight from the stored pixels, so
+    // the image itself is left as it was. Other formats need it materialized.
     ImageStatus writeImage(const string &filePath, const Image<T> &image);
+    // Writes a (possibly strided) view; width/height are taken from the view,
+    // format and maxValue from `metadata`.
+    ImageStatus writeImage(const string &filePath, const ImageView<const T> &view, const ImageMetadata &metadata);
 
 private:
+    ImageStatus writePGM(const string &filePath, const ImageView<const T> &view, const ImageMetadata &metadata);
     ImageStatus writePGM(const string &filePath, const Image<T> &image);
-    ImageStatus writePNG(const string &filePath, const Image<T> &image);
-    ImageStatus writeJPEG(const string &filePath, const Image<T> &image);
-    ImageStatus writeBMP(const string &filePath, const Image<T> &image);
+    // Header plus `height` rows of `width` samples, row i taken from
+    // rowAt(i, scratch) (a pointer that may point into `scratch`).
+    template <typename RowSource>
+    ImageStatus writePGMRows(const string &filePath, uint32_t width, uint32_t height, uint32_t maxValue,
+                             RowSource rowAt);
+    ImageStatus writePNG(const string &filePath, const ImageView<const T> &view, const ImageMetadata &metadata);
+    ImageStatus writeJPEG(const string &filePath, const ImageView<const T> &view, const ImageMetadata &metadata);
+    ImageStatus writeBMP(const string &filePath, const ImageView<const T> &view, const ImageMetadata &metadata);
 };
 
 #endif // IMAGE_WRITER_HPP
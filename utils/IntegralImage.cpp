@@ -0,0 +1,203 @@
+#ifndef INTEGRAL_IMAGE_CPP
+#define INTEGRAL_IMAGE_CPP
+
+#include "IntegralImage.hpp"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+template class IntegralImage<uint8_t>;
+template class IntegralImage<uint16_t>;
+template class IntegralImage<uint32_t>;
+template class IntegralImage<uint64_t>;
+
+// True when `pixels` values of at most `perPixel` each sum to no more than `limit`.
+template <typename A>
+static bool sumFits(A perPixel, uint64_t pixels, A limit)
+{
+    return pixels == 0 || perPixel <= limit / pixels;
+}
+
+// Fills the (width + 1) x (height + 1) table with running sums of
+// value(sample); row 0 and column 0 stay zero.
+template <typename T, typename A, typename Value>
+static void buildTable(const ImageView<const T> &image, vector<A> &table, Value value)
+{
+    size_t width = image.width();
+    size_t stride = width + 1;
+    table.assign(stride * (image.height() + 1), A(0));
+    for (uint32_t y = 0; y < image.height(); y++)
+    {
+        const T *row = image.row(y);
+        const A *above = table.data() + y * stride;
+        A *current = table.data() + (y + 1) * stride;
+        A rowSum = 0;
+        for (size_t x = 0; x < width; x++)
+        {
+            rowSum += value(row[x]);
+            current[x + 1] = above[x + 1] + rowSum;
+        }
+    }
+}
+
+// Sum over [x0, x1) x [y0, y1). Unsigned wrap-around in the intermediate
+// terms cancels out because the true result fits in A.
+template <typename A>
+static inline A rectangleSum(const vector<A> &table, size_t stride, size_t x0, size_t y0, size_t x1, size_t y1)
+{
+    const A *top = table.data() + y0 * stride;
+    const A *bottom = table.data() + y1 * stride;
+    return bottom[x1] - bottom[x0] - top[x1] + top[x0];
+}
+
+template <typename T>
+IntegralImage<T>::IntegralImage(const ImageView<const T> &image, bool withSquares)
+    : imageWidth(image.width()), imageHeight(image.height()), tableStride(image.width() + 1),
+      squaresStored(withSquares)
+{
+    if (image.empty())
+    {
+        throw invalid_argument("Image is empty");
+    }
+    if (image.channels() != 1)
+    {
+        throw invalid_argument("Integral images need a single-channel image");
+    }
+
+    uint64_t pixels = static_cast<uint64_t>(imageWidth) * imageHeight;
+    Sum maxSample = numeric_limits<T>::max();
+    if (!sumFits<Sum>(maxSample, pixels, static_cast<Sum>(~Sum(0))))
+    {
+        throw overflow_error("Image too large for the integral image accumulator");
+    }
+    sumsNarrow = sumFits<Sum>(maxSample, pixels, numeric_limits<uint32_t>::max());
+    if (sumsNarrow)
+        buildTable(image, narrowSums, [](T v) { return static_cast<uint32_t>(v); });
+    else
+        buildTable(image, wideSums, [](T v) { return static_cast<Sum>(v); });
+
+    if (withSquares)
+    {
+        SquareSum maxSquare = static_cast<SquareSum>(maxSample) * static_cast<SquareSum>(maxSample);
+        if (maxSquare / static_cast<SquareSum>(maxSample) != static_cast<SquareSum>(maxSample) ||
+            !sumFits<SquareSum>(maxSquare, pixels, static_cast<SquareSum>(~SquareSum(0))))
+        {
+            throw overflow_error("Image too large for the squared-sum accumulator");
+        }
+        squaresNarrow = sumFits<SquareSum>(maxSquare, pixels, numeric_limits<uint32_t>::max());
+        if (squaresNarrow)
+            buildTable(image, narrowSquares, [](T v) { return static_cast<uint32_t>(v) * v; });
+        else
+            buildTable(image, wideSquares, [](T v) { return static_cast<SquareSum>(v) * v; });
+    }
+}
+
+template <typename T>
+void IntegralImage<T>::checkRectangle(uint32_t x, uint32_t y, uint32_t w, uint32_t h) const
+{
+    if (x > imageWidth || y > imageHeight || w > imageWidth - x || h > imageHeight - y)
+    {
+        throw out_of_range("Rectangle exceeds image bounds");
+    }
+}
+
+template <typename T>
+typename IntegralImage<T>::Sum IntegralImage<T>::sum(uint32_t x, uint32_t y, uint32_t w, uint32_t h) const
+{
+    checkRectangle(x, y, w, h);
+    if (sumsNarrow)
+        return rectangleSum(narrowSums, tableStride, x, y, size_t(x) + w, size_t(y) + h);
+    return rectangleSum(wideSums, tableStride, x, y, size_t(x) + w, size_t(y) + h);
+}
+
+template <typename T>
+typename IntegralImage<T>::SquareSum IntegralImage<T>::squareSum(uint32_t x, uint32_t y, uint32_t w,
+                                                                 uint32_t h) const
+{
+    if (!squaresStored)
+    {
+        throw logic_error("Integral image was built without squared sums");
+    }
+    checkRectangle(x, y, w, h);
+    if (squaresNarrow)
+        return rectangleSum(narrowSquares, tableStride, x, y, size_t(x) + w, size_t(y) + h);
+    return rectangleSum(wideSquares, tableStride, x, y, size_t(x) + w, size_t(y) + h);
+}
+
+template <typename T>
+double IntegralImage<T>::mean(uint32_t x, uint32_t y, uint32_t w, uint32_t h) const
+{
+    if (w == 0 || h == 0)
+    {
+        throw invalid_argument("Rectangle is empty");
+    }
+    return static_cast<double>(sum(x, y, w, h)) / (static_cast<double>(w) * h);
+}
+
+template <typename T>
+double IntegralImage<T>::variance(uint32_t x, uint32_t y, uint32_t w, uint32_t h) const
+{
+    if (w == 0 || h == 0)
+    {
+        throw invalid_argument("Rectangle is empty");
+    }
+    SquareSum squares = squareSum(x, y, w, h);
+    Sum total = sum(x, y, w, h);
+    uint64_t n = static_cast<uint64_t>(w) * h;
+    // With n < 2^32 and samples below 2^32, n * sum(v^2) - sum(v)^2 is
+    // exact in 128 bits, which avoids the cancellation of E[v^2] - E[v]^2
+    // on flat regions.
+    if (sizeof(T) <= 4 && sizeof(WideSum) == 16 && n <= UINT32_MAX)
+    {
+        WideSum scaled = static_cast<WideSum>(n) * squares - static_cast<WideSum>(total) * total;
+        return static_cast<double>(scaled) / (static_cast<double>(n) * static_cast<double>(n));
+    }
+    long double m = static_cast<long double>(total) / n;
+    long double v = static_cast<long double>(squares) / n - m * m;
+    return max(0.0, static_cast<double>(v));
+}
+
+// Box mean over the window clipped to the image, divided by the full
+// kernel area so that outside samples count as zero. For odd k the area is
+// odd and the mean is never exactly halfway, so (s + area / 2) / area rounds.
+template <typename T, typename Sum, typename A>
+static void boxFromTable(const vector<A> &table, size_t stride, uint32_t width, uint32_t height, int kernelSize,
+                         Image<T> &output)
+{
+    size_t border = kernelSize / 2;
+    Sum area = static_cast<Sum>(kernelSize) * static_cast<Sum>(kernelSize);
+    vector<size_t> left(width), right(width);
+    for (size_t x = 0; x < width; x++)
+    {
+        left[x] = x > border ? x - border : 0;
+        right[x] = min<size_t>(width, x + border + 1);
+    }
+    for (size_t y = 0; y < height; y++)
+    {
+        const A *top = table.data() + (y > border ? y - border : 0) * stride;
+        const A *bottom = table.data() + min<size_t>(height, y + border + 1) * stride;
+        T *outRow = output.row(y);
+        for (size_t x = 0; x < width; x++)
+        {
+            A s = bottom[right[x]] - bottom[left[x]] - top[right[x]] + top[left[x]];
+            outRow[x] = static_cast<T>((static_cast<Sum>(s) + area / 2) / area);
+        }
+    }
+}
+
+template <typename T>
+Image<T> IntegralImage<T>::boxFilter(int kernelSize) const
+{
+    if (kernelSize < 1 || kernelSize % 2 == 0)
+    {
+        throw invalid_argument("Invalid kernel size");
+    }
+    Image<T> output(imageWidth, imageHeight);
+    if (sumsNarrow)
+        boxFromTable<T, Sum>(narrowSums, tableStride, imageWidth, imageHeight, kernelSize, output);
+    else
+        boxFromTable<T, Sum>(wideSums, tableStride, imageWidth, imageHeight, kernelSize, output);
+    return output;
+}
+
+#endif // INTEGRAL_IMAGE_CPP
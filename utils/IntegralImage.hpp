@@ -0,0 +1,73 @@
+#ifndef INTEGRAL_IMAGE_HPP
+#define INTEGRAL_IMAGE_HPP
+
+#include "Image.hpp"
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+using namespace std;
+
+#ifdef __SIZEOF_INT128__
+using WideSum = unsigned __int128;
+#else
+// Without 128-bit integers, sums of 64-bit samples and squared sums of
+// 32-bit samples are limited to what 64 bits can hold.
+using WideSum = uint64_t;
+#endif
+
+// Summed-area table of a single-channel image: after one pass over the
+// pixels, the sum, mean and variance of any rectangle cost four lookups.
+// The table is (width + 1) x (height + 1) with a zero first row and column,
+// so queries need no edge cases.
+//
+// Values are accumulated exactly in unsigned integers. The table is stored
+// 32 bits wide when the whole-image sum is guaranteed to fit and in `Sum`
+// otherwise; the constructor throws overflow_error if even `Sum` could
+// overflow for an image of this size. The squared-sum table used by
+// variance() is optional and sized the same way.
+template <typename T = uint8_t>
+class IntegralImage
+{
+public:
+    // Accumulators for sums and squared sums of T.
+    using Sum = conditional_t<(sizeof(T) < 8), uint64_t, WideSum>;
+    using SquareSum = conditional_t<(sizeof(T) < 4), uint64_t, WideSum>;
+
+    explicit IntegralImage(const ImageView<const T> &image, bool withSquares = false);
+
+    uint32_t width() const { return imageWidth; }
+    uint32_t height() const { return imageHeight; }
+    bool hasSquares() const { return squaresStored; }
+
+    // Rectangle [x, x + w) x [y, y + h); it must lie inside the image.
+    Sum sum(uint32_t x, uint32_t y, uint32_t w, uint32_t h) const;
+    SquareSum squareSum(uint32_t x, uint32_t y, uint32_t w, uint32_t h) const;
+    // Mean and population variance of a non-empty rectangle. variance()
+    // needs the squared-sum table.
+    double mean(uint32_t x, uint32_t y, uint32_t w, uint32_t h) const;
+    double variance(uint32_t x, uint32_t y, uint32_t w, uint32_t h) const;
+
+    // Zero-bordered kernelSize x kernelSize box mean of the source image,
+    // rounded to the nearest value: the same result as
+    // BoxFilter::applyBoxFilterFFT, computed exactly. Any number of kernel
+    // sizes can be evaluated from the one table.
+    Image<T> boxFilter(int kernelSize) const;
+
+private:
+    void checkRectangle(uint32_t x, uint32_t y, uint32_t w, uint32_t h) const;
+
+    uint32_t imageWidth = 0;
+    uint32_t imageHeight = 0;
+    size_t tableStride = 0; // width + 1
+    bool sumsNarrow = false;
+    bool squaresStored = false;
+    bool squaresNarrow = false;
+    // Exactly one vector of each pair is filled.
+    vector<uint32_t> narrowSums;
+    vector<Sum> wideSums;
+    vector<uint32_t> narrowSquares;
+    vector<SquareSum> wideSquares;
+};
+
+#endif // INTEGRAL_IMAGE_HPP
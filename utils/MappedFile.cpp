@@ -0,0 +1,111 @@
+#include "MappedFile.hpp"
+#include <fstream>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MAPPED_FILE_HAS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+{
+    *this = move(other);
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept
+{
+    if (this != &other)
+    {
+        close();
+        bytes = other.bytes;
+        length = other.length;
+        mapped = other.mapped;
+        fallback = move(other.fallback);
+        if (!mapped)
+        {
+            bytes = fallback.empty() ? nullptr : fallback.data();
+        }
+        other.bytes = nullptr;
+        other.length = 0;
+        other.mapped = false;
+    }
+    return *this;
+}
+
+ImageStatus MappedFile::open(const string &filePath)
+{
+    close();
+#ifdef MAPPED_FILE_HAS_MMAP
+    int fd = ::open(filePath.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return ImageStatus::FILE_NOT_FOUND;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+    {
+        ::close(fd);
+        return ImageStatus::FILE_READ_ERROR;
+    }
+    if (info.st_size == 0)
+    {
+        ::close(fd);
+        return ImageStatus::FILE_READ_ERROR;
+    }
+    void *address = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (address == MAP_FAILED)
+    {
+        return ImageStatus::FILE_READ_ERROR;
+    }
+    // Pixels are consumed front to back exactly once.
+    madvise(address, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+    bytes = static_cast<const uint8_t *>(address);
+    length = static_cast<size_t>(info.st_size);
+    mapped = true;
+    return ImageStatus::SUCCESS;
+#else
+    ifstream file(filePath, ios::binary | ios::ate);
+    if (!file.is_open())
+    {
+        return ImageStatus::FILE_NOT_FOUND;
+    }
+    streamoff fileSize = file.tellg();
+    if (fileSize <= 0)
+    {
+        return ImageStatus::FILE_READ_ERROR;
+    }
+    fallback.resize(static_cast<size_t>(fileSize));
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char *>(fallback.data()), fileSize))
+    {
+        fallback.clear();
+        return ImageStatus::FILE_READ_ERROR;
+    }
+    bytes = fallback.data();
+    length = fallback.size();
+    return ImageStatus::SUCCESS;
+#endif
+}
+
+void MappedFile::close()
+{
+#ifdef MAPPED_FILE_HAS_MMAP
+    if (mapped && bytes != nullptr)
+    {
+        munmap(const_cast<uint8_t *>(bytes), length);
+    }
+#endif
+    fallback.clear();
+    bytes = nullptr;
+    length = 0;
+    mapped = false;
+}
@@ -0,0 +1,39 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include "ImageStatus.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Read-only memory mapping of a whole file (RAII, move-only).
+// On platforms without mmap the file is read into an owned buffer instead,
+// so callers always see one contiguous byte range.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+
+    ImageStatus open(const string &filePath);
+    void close();
+
+    const uint8_t *data() const { return bytes; }
+    size_t size() const { return length; }
+    bool isOpen() const { return bytes != nullptr; }
+
+private:
+    const uint8_t *bytes = nullptr;
+    size_t length = 0;
+    bool mapped = false;
+    vector<uint8_t> fallback;
+};
+
+#endif // MAPPED_FILE_HPP
@@ -0,0 +1,38 @@
+#ifndef MAPPED_IMAGE_HPP
+#define MAPPED_IMAGE_HPP
+
+#include "Image.hpp"
+#include "MappedFile.hpp"
+using namespace std;
+
+// Image loaded through a memory mapping (see ImageReader::readImageMapped).
+// When the file's sample size matches T (8-bit PGM read as uint8_t) the view
+// points straight into the mapped pages; otherwise the samples are decoded
+// once into an owned aligned buffer and the mapping is released.
+template <typename T = uint8_t>
+class MappedImage
+{
+public:
+    const ImageMetadata &metadata() const { return imageMetadata; }
+    ImageView<const T> view() const { return pixels; }
+    bool isZeroCopy() const { return file.isOpen(); }
+
+    // Deep copy into a regular owning image.
+    Image<T> toImage() const
+    {
+        Image<T> image = copyImage(pixels);
+        image.metadata = imageMetadata;
+        return image;
+    }
+
+private:
+    template <typename U>
+    friend class ImageReader;
+
+    ImageMetadata imageMetadata;
+    MappedFile file;
+    Image<T> decoded;
+    ImageView<const T> pixels;
+};
+
+#endif // MAPPED_IMAGE_HPP
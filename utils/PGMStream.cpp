@@ -0,0 +1,289 @@
+#ifndef PGM_STREAM_CPP
+#define PGM_STREAM_CPP
+
+#include "PGMStream.hpp"
+#include "ImageReader.hpp"
+#include "ImageWriter.hpp"
+#include <algorithm>
+
+template class PGMBandReader<uint8_t>;
+template class PGMBandReader<uint16_t>;
+template class PGMBandReader<uint32_t>;
+template class PGMBandReader<uint64_t>;
+
+template class PGMBandWriter<uint8_t>;
+template class PGMBandWriter<uint16_t>;
+template class PGMBandWriter<uint32_t>;
+template class PGMBandWriter<uint64_t>;
+
+template ImageStatus filterPGMInBands<uint8_t>(const string &, const string &, uint32_t, uint32_t, const function<Image<uint8_t>(const ImageView<const uint8_t> &)> &);
+template ImageStatus filterPGMInBands<uint16_t>(const string &, const string &, uint32_t, uint32_t, const function<Image<uint16_t>(const ImageView<const uint16_t> &)> &);
+template ImageStatus filterPGMInBands<uint32_t>(const string &, const string &, uint32_t, uint32_t, const function<Image<uint32_t>(const ImageView<const uint32_t> &)> &);
+template ImageStatus filterPGMInBands<uint64_t>(const string &, const string &, uint32_t, uint32_t, const function<Image<uint64_t>(const ImageView<const uint64_t> &)> &);
+
+// Largest header prefix we are willing to scan for a P5 header.
+static const size_t MAX_HEADER_BYTES = 1 << 20;
+
+static size_t bytesPerSample(uint32_t maxValue)
+{
+    return maxValue <= 255 ? 1 : 2;
+}
+
+//--------------------------------------------------
+// PGMBandReader
+//--------------------------------------------------
+template <typename T>
+PGMBandReader<T>::PGMBandReader(uint32_t bandRows, uint32_t halo)
+    : bandRows(bandRows), halo(halo) {}
+
+template <typename T>
+ImageStatus PGMBandReader<T>::open(const string &filePath)
+{
+    if (bandRows == 0)
+    {
+        return ImageStatus::INVALID_PARAMETERS;
+    }
+
+    file.close();
+    file.clear();
+    file.open(filePath, ios::binary);
+    if (!file.is_open())
+    {
+        return ImageStatus::FILE_NOT_FOUND;
+    }
+    file.seekg(0, ios::end);
+    size_t fileSize = static_cast<size_t>(file.tellg());
+    file.seekg(0);
+
+    // Only the header is read here; grow the prefix until it parses.
+    vector<uint8_t> prefix;
+    size_t headerSize = 0;
+    ImageStatus status = ImageStatus::PARSE_ERROR;
+    for (size_t chunk = 4096; status == ImageStatus::PARSE_ERROR; chunk *= 2)
+    {
+        size_t length = min(chunk, fileSize);
+        prefix.resize(length);
+        file.seekg(0);
+        if (!file.read(reinterpret_cast<char *>(prefix.data()), length))
+        {
+            return ImageStatus::FILE_READ_ERROR;
+        }
+        status = parsePNMHeader(prefix.data(), prefix.size(), imageMetadata, headerSize);
+        if (length == fileSize || length >= MAX_HEADER_BYTES)
+        {
+            break;
+        }
+    }
+    if (status != ImageStatus::SUCCESS)
+    {
+        return status;
+    }
+    if (imageMetadata.format != ImageFormat::PGM || imageMetadata.maxValue > 65535)
+    {
+        return ImageStatus::UNSUPPORTED_FORMAT;
+    }
+    if (bytesPerSample(imageMetadata.maxValue) > sizeof(T))
+    {
+        return ImageStatus::INVALID_DATASIZE;
+    }
+    size_t rasterBytes = static_cast<size_t>(imageMetadata.width) * imageMetadata.height * bytesPerSample(imageMetadata.maxValue);
+    if (fileSize - headerSize < rasterBytes)
+    {
+        return ImageStatus::FILE_READ_ERROR;
+    }
+
+    file.clear();
+    file.seekg(headerSize);
+    uint32_t capacity = min<uint64_t>(imageMetadata.height, 2ull * bandRows - 1 + 2ull * halo);
+    buffer.allocate(imageMetadata.width, capacity);
+    bufferFirstRow = 0;
+    bufferRowCount = 0;
+    nextCoreRow = 0;
+    return ImageStatus::SUCCESS;
+}
+
+template <typename T>
+ImageStatus PGMBandReader<T>::readRows(uint32_t count, const ImageView<T> &dst)
+{
+    size_t rowLength = static_cast<size_t>(imageMetadata.width) * bytesPerSample(imageMetadata.maxValue);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (sizeof(T) == 1)
+        {
+            if (!file.read(reinterpret_cast<char *>(dst.row(i)), rowLength))
+                return ImageStatus::FILE_READ_ERROR;
+            continue;
+        }
+        rowBytes.resize(rowLength);
+        if (!file.read(reinterpret_cast<char *>(rowBytes.data()), rowLength))
+            return ImageStatus::FILE_READ_ERROR;
+        decodePGMRows(rowBytes.data(), imageMetadata.maxValue, dst.subView(0, i, dst.width(), 1));
+    }
+    return ImageStatus::SUCCESS;
+}
+
+template <typename T>
+ImageStatus PGMBandReader<T>::readNextBand(RowBand<T> &band)
+{
+    if (!file.is_open() || done())
+    {
+        return ImageStatus::INVALID_PARAMETERS;
+    }
+
+    uint32_t height = imageMetadata.height;
+    uint32_t coreFirst = nextCoreRow;
+    uint32_t remaining = height - coreFirst;
+    uint32_t coreCount = remaining < 2 * static_cast<uint64_t>(bandRows) ? remaining : bandRows;
+    uint32_t needFirst = coreFirst > halo ? coreFirst - halo : 0;
+    uint32_t needEnd = static_cast<uint32_t>(min<uint64_t>(height, static_cast<uint64_t>(coreFirst) + coreCount + halo));
+
+    // Carry over rows still needed from the previous band.
+    uint32_t bufferEnd = bufferFirstRow + bufferRowCount;
+    uint32_t kept = 0;
+    if (bufferRowCount > 0 && needFirst < bufferEnd)
+    {
+        kept = bufferEnd - needFirst;
+        uint32_t shift = needFirst - bufferFirstRow;
+        if (shift > 0)
+        {
+            copy(buffer.row(shift), buffer.row(shift) + kept * buffer.stride(), buffer.row(0));
+        }
+    }
+
+    uint32_t toRead = needEnd - needFirst - kept;
+    ImageStatus status = readRows(toRead, buffer.view().subView(0, kept, imageMetadata.width, toRead));
+    if (status != ImageStatus::SUCCESS)
+    {
+        return status;
+    }
+
+    bufferFirstRow = needFirst;
+    bufferRowCount = needEnd - needFirst;
+    nextCoreRow = coreFirst + coreCount;
+
+    band.rows = buffer.cview().subView(0, 0, imageMetadata.width, bufferRowCount);
+    band.firstRow = coreFirst;
+    band.rowCount = coreCount;
+    band.haloAbove = coreFirst - needFirst;
+    band.haloBelow = needEnd - coreFirst - coreCount;
+    return ImageStatus::SUCCESS;
+}
+
+//--------------------------------------------------
+// PGMBandWriter
+//--------------------------------------------------
+template <typename T>
+ImageStatus PGMBandWriter<T>::open(const string &filePath, const ImageMetadata &metadata)
+{
+    if (metadata.width == 0 || metadata.height == 0 || metadata.maxValue == 0)
+    {
+        return ImageStatus::INVALID_DIMENSIONS;
+    }
+    if (metadata.maxValue > 65535)
+    {
+        return ImageStatus::UNSUPPORTED_FORMAT;
+    }
+
+    file.close();
+    file.clear();
+    file.open(filePath, ios::binary);
+    if (!file.is_open())
+    {
+        return ImageStatus::FILE_WRITE_ERROR;
+    }
+    imageMetadata = metadata;
+    rowsWritten = 0;
+
+    file << "P5\n";
+    file << metadata.width << " " << metadata.height << "\n";
+    file << metadata.maxValue << "\n";
+    return file ? ImageStatus::SUCCESS : ImageStatus::FILE_WRITE_ERROR;
+}
+
+template <typename T>
+ImageStatus PGMBandWriter<T>::writeRows(const ImageView<const T> &rows)
+{
+    if (!file.is_open())
+    {
+        return ImageStatus::FILE_WRITE_ERROR;
+    }
+    if (rows.width() != imageMetadata.width || rows.channels() != 1 ||
+        rows.height() > imageMetadata.height - rowsWritten)
+    {
+        return ImageStatus::INVALID_DIMENSIONS;
+    }
+
+    for (uint32_t i = 0; i < rows.height(); ++i)
+    {
+        const T *row = rows.row(i);
+        if (sizeof(T) == 1)
+        {
+            file.write(reinterpret_cast<const char *>(row), rows.width());
+            continue;
+        }
+        encodePGMRow(row, rows.width(), imageMetadata.maxValue, rowBytes);
+        file.write(reinterpret_cast<const char *>(rowBytes.data()), rowBytes.size());
+    }
+    rowsWritten += rows.height();
+    return file ? ImageStatus::SUCCESS : ImageStatus::FILE_WRITE_ERROR;
+}
+
+template <typename T>
+ImageStatus PGMBandWriter<T>::close()
+{
+    if (!file.is_open())
+    {
+        return ImageStatus::FILE_WRITE_ERROR;
+    }
+    file.close();
+    if (!file)
+    {
+        return ImageStatus::FILE_WRITE_ERROR;
+    }
+    return rowsWritten == imageMetadata.height ? ImageStatus::SUCCESS : ImageStatus::INVALID_DIMENSIONS;
+}
+
+//--------------------------------------------------
+// Band-by-band filtering
+//--------------------------------------------------
+template <typename T>
+ImageStatus filterPGMInBands(const string &inputPath, const string &outputPath,
+                             uint32_t bandRows, uint32_t halo,
+                             const function<Image<T>(const ImageView<const T> &)> &filter)
+{
+    PGMBandReader<T> reader(bandRows, halo);
+    ImageStatus status = reader.open(inputPath);
+    if (status != ImageStatus::SUCCESS)
+    {
+        return status;
+    }
+    PGMBandWriter<T> writer;
+    status = writer.open(outputPath, reader.metadata());
+    if (status != ImageStatus::SUCCESS)
+    {
+        return status;
+    }
+
+    RowBand<T> band;
+    while (!reader.done())
+    {
+        status = reader.readNextBand(band);
+        if (status != ImageStatus::SUCCESS)
+        {
+            return status;
+        }
+        Image<T> filtered = filter(band.rows);
+        if (filtered.metadata.width != band.rows.width() || filtered.metadata.height != band.rows.height())
+        {
+            return ImageStatus::INVALID_DIMENSIONS;
+        }
+        status = writer.writeRows(filtered.cview().subView(0, band.haloAbove, band.rows.width(), band.rowCount));
+        if (status != ImageStatus::SUCCESS)
+        {
+            return status;
+        }
+    }
+    return writer.close();
+}
+
+#endif // PGM_STREAM_CPP
@@ -0,0 +1,84 @@
+#ifndef PGM_STREAM_HPP
+#define PGM_STREAM_HPP
+
+#include "Image.hpp"
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+using namespace std;
+
+// One band of consecutive image rows handed out by PGMBandReader.
+// `rows` covers [firstRow - haloAbove, firstRow + rowCount + haloBelow);
+// halos are clipped at the top and bottom of the image.
+template <typename T = uint8_t>
+struct RowBand
+{
+    ImageView<const T> rows;
+    uint32_t firstRow = 0;
+    uint32_t rowCount = 0;
+    uint32_t haloAbove = 0;
+    uint32_t haloBelow = 0;
+
+    // The rows this band is responsible for, without halos.
+    ImageView<const T> core() const { return rows.subView(0, haloAbove, rows.width(), rowCount); }
+};
+
+// Sequential P5 reader that keeps at most one band (plus halos) in memory.
+// Halo rows shared by neighbouring bands are carried over, so every file row
+// is read exactly once. The final band absorbs a remainder shorter than
+// `bandRows`, so each band has at least min(bandRows, height) core rows.
+template <typename T = uint8_t>
+class PGMBandReader
+{
+public:
+    PGMBandReader(uint32_t bandRows, uint32_t halo = 0);
+
+    ImageStatus open(const string &filePath);
+    const ImageMetadata &metadata() const { return imageMetadata; }
+    bool done() const { return nextCoreRow >= imageMetadata.height; }
+
+    // Reads the next band. The returned view stays valid until the next call.
+    ImageStatus readNextBand(RowBand<T> &band);
+
+private:
+    ImageStatus readRows(uint32_t count, const ImageView<T> &dst);
+
+    uint32_t bandRows;
+    uint32_t halo;
+    ifstream file;
+    ImageMetadata imageMetadata;
+    Image<T> buffer;
+    vector<uint8_t> rowBytes;
+    uint32_t bufferFirstRow = 0; // image row held in buffer row 0
+    uint32_t bufferRowCount = 0;
+    uint32_t nextCoreRow = 0;
+};
+
+// Sequential P5 writer: the header is written on open(), rows are appended
+// with writeRows() and close() checks that exactly `height` rows arrived.
+template <typename T = uint8_t>
+class PGMBandWriter
+{
+public:
+    ImageStatus open(const string &filePath, const ImageMetadata &metadata);
+    ImageStatus writeRows(const ImageView<const T> &rows);
+    ImageStatus close();
+
+private:
+    ofstream file;
+    ImageMetadata imageMetadata;
+    vector<uint8_t> rowBytes;
+    uint32_t rowsWritten = 0;
+};
+
+// Runs a size-preserving filter over a P5 file band by band and streams the
+// result to `outputPath`. `halo` must cover the filter's vertical reach
+// (kernelSize / 2 for the box and Gaussian filters) for the output to match
+// filtering the whole image at once.
+template <typename T = uint8_t>
+ImageStatus filterPGMInBands(const string &inputPath, const string &outputPath,
+                             uint32_t bandRows, uint32_t halo,
+                             const function<Image<T>(const ImageView<const T> &)> &filter);
+
+#endif // PGM_STREAM_HPP
@@ -0,0 +1,134 @@
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+ThreadPool::ThreadPool(size_t workerCount)
+{
+    workers.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; i++)
+    {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        lock_guard<mutex> lock(queueMutex);
+        stopping = true;
+    }
+    queueReady.notify_all();
+    for (thread &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::workerLoop()
+{
+    for (;;)
+    {
+        function<void()> task;
+        {
+            unique_lock<mutex> lock(queueMutex);
+            queueReady.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (tasks.empty())
+            {
+                return;
+            }
+            task = move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+void ThreadPool::parallelFor(size_t begin, size_t end, const function<void(size_t, size_t)> &body)
+{
+    if (begin >= end)
+    {
+        return;
+    }
+    size_t count = end - begin;
+    // A few chunks per thread so that uneven chunks still balance out.
+    size_t chunkCount = min(count, threadCount() * 4);
+    if (workers.empty() || chunkCount == 1)
+    {
+        body(begin, end);
+        return;
+    }
+
+    struct LoopState
+    {
+        atomic<size_t> nextChunk{0};
+        size_t finishedChunks = 0;
+        mutex doneMutex;
+        condition_variable allDone;
+        exception_ptr error;
+    };
+    shared_ptr<LoopState> state = make_shared<LoopState>();
+
+    // Every participant claims chunks until none are left. A helper that
+    // starts after the loop is exhausted returns without touching `body`, so
+    // the caller may return as soon as all claimed chunks have finished.
+    auto runChunks = [state, &body, begin, count, chunkCount]()
+    {
+        for (;;)
+        {
+            size_t chunk = state->nextChunk.fetch_add(1);
+            if (chunk >= chunkCount)
+            {
+                return;
+            }
+            size_t chunkBegin = begin + count * chunk / chunkCount;
+            size_t chunkEnd = begin + count * (chunk + 1) / chunkCount;
+            exception_ptr error;
+            try
+            {
+                body(chunkBegin, chunkEnd);
+            }
+            catch (...)
+            {
+                error = current_exception();
+            }
+            lock_guard<mutex> lock(state->doneMutex);
+            if (error && !state->error)
+            {
+                state->error = error;
+            }
+            if (++state->finishedChunks == chunkCount)
+            {
+                state->allDone.notify_all();
+            }
+        }
+    };
+
+    size_t helpers = min(workers.size(), chunkCount - 1);
+    {
+        lock_guard<mutex> lock(queueMutex);
+        for (size_t i = 0; i < helpers; i++)
+        {
+            tasks.emplace_back(runChunks);
+        }
+    }
+    queueReady.notify_all();
+
+    runChunks();
+    unique_lock<mutex> lock(state->doneMutex);
+    state->allDone.wait(lock, [&] { return state->finishedChunks == chunkCount; });
+    if (state->error)
+    {
+        rethrow_exception(state->error);
+    }
+}
+
+ThreadPool &ThreadPool::shared()
+{
+    static ThreadPool pool([] {
+        unsigned hardware = thread::hardware_concurrency();
+        return hardware > 1 ? static_cast<size_t>(hardware - 1) : size_t(0);
+    }());
+    return pool;
+}
@@ -0,0 +1,49 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace std;
+
+// Fixed set of worker threads for data-parallel loops. The calling thread
+// always takes part in its own loop, so a pool with zero workers simply
+// runs everything inline and a parallelFor issued from inside another one
+// cannot deadlock waiting for a busy worker.
+class ThreadPool
+{
+public:
+    explicit ThreadPool(size_t workerCount);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Workers plus the calling thread.
+    size_t threadCount() const { return workers.size() + 1; }
+
+    // Calls body(chunkBegin, chunkEnd) over contiguous chunks covering
+    // [begin, end) and returns once every chunk has finished. Which thread
+    // runs a chunk is unspecified, so results are independent of the thread
+    // count as long as chunks do not depend on each other. The first
+    // exception thrown by a chunk is rethrown here.
+    void parallelFor(size_t begin, size_t end, const function<void(size_t, size_t)> &body);
+
+    // Process-wide pool with one worker per additional hardware thread.
+    static ThreadPool &shared();
+
+private:
+    void workerLoop();
+
+    vector<thread> workers;
+    deque<function<void()>> tasks;
+    mutex queueMutex;
+    condition_variable queueReady;
+    bool stopping = false;
+};
+
+#endif // THREAD_POOL_HPP